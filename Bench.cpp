@@ -0,0 +1,531 @@
+// Headless benchmark of the data path. Seeds generated tables into a local
+// Postgres, drives Table through an ImGui context that has no window or GPU
+// backend (frames are built and discarded), and prints one JSON document with
+// latency percentiles, throughput and heap allocation counts per scenario.
+//
+//   dbe_bench [--conn "dbname=postgres"] [--rows 10000,100000,1000000]
+//             [--shapes narrow,wide] [--iterations 20] [--cache-mb 0]
+//             [--reseed] [--output results.json]
+//
+// Tables live in the dbe_bench schema and are created once per size and shape;
+// --rows 10000000 adds the 10M-row tables. Allocation counts include the query
+// workers, since decoding happens there.
+#include "ConnectionPool.h"
+#include "PageCache.h"
+#include "SchemaCatalog.h"
+#include "Table.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <imgui.h>
+#include <iostream>
+#include <libpq-fe.h>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+} // namespace
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void *memory = malloc(size ? size : 1);
+    if (!memory)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void *memory) noexcept { free(memory); }
+void operator delete(void *memory, size_t) noexcept { free(memory); }
+
+namespace
+{
+struct Options
+{
+    std::string connInfo = "dbname=postgres";
+    std::vector<int> sizes = {10000, 100000, 1000000};
+    std::vector<std::string> shapes = {"narrow", "wide"};
+    int iterations = 20;
+    int cacheMb = 0;
+    bool reseed = false;
+    std::string output;
+};
+
+// One scenario's samples, reduced to the numbers in the report
+struct Result
+{
+    std::string table;
+    std::string shape;
+    int rows = 0;
+    std::string scenario;
+    std::vector<double> samplesMs;
+    double unitsPerSample = 1; // Rows (or operations) each sample processed
+    const char *unit = "ops";
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    std::vector<Trace::Summary> spans;
+};
+
+using Clock = std::chrono::steady_clock;
+double millisSince(Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    if (const char *conn = getenv("DBE_BENCH_CONN"))
+    {
+        options.connInfo = conn;
+    }
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto list = [](const char *text)
+        {
+            std::vector<std::string> items;
+            std::stringstream stream(text);
+            for (std::string item; std::getline(stream, item, ',');)
+            {
+                items.push_back(item);
+            }
+            return items;
+        };
+
+        if (arg == "--reseed")
+        {
+            options.reseed = true;
+            continue;
+        }
+        if (!value)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        i++;
+
+        if (arg == "--conn")
+        {
+            options.connInfo = value;
+        }
+        else if (arg == "--rows")
+        {
+            options.sizes.clear();
+            for (const auto &item : list(value))
+            {
+                options.sizes.push_back(std::max(1, atoi(item.c_str())));
+            }
+        }
+        else if (arg == "--shapes")
+        {
+            options.shapes = list(value);
+        }
+        else if (arg == "--iterations")
+        {
+            options.iterations = std::max(1, atoi(value));
+        }
+        else if (arg == "--cache-mb")
+        {
+            options.cacheMb = std::max(0, atoi(value));
+        }
+        else if (arg == "--output")
+        {
+            options.output = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool exec(PGconn *conn, const std::string &sql)
+{
+    PGresult *result = PQexec(conn, sql.c_str());
+    bool ok = PQresultStatus(result) == PGRES_COMMAND_OK || PQresultStatus(result) == PGRES_TUPLES_OK;
+    if (!ok)
+    {
+        std::cerr << "Seeding failed: " << PQerrorMessage(conn) << std::endl;
+    }
+    PQclear(result);
+    return ok;
+}
+
+std::string tableName(const std::string &shape, int rows) { return "dbe_bench." + shape + "_" + std::to_string(rows); }
+
+// Narrow: a key, an indexed bucket, a text label and a timestamp. Wide: the same
+// plus 25 more columns spread over integer, numeric, float, text, boolean, uuid
+// and jsonb types. Values derive from the row number, so every seed is identical.
+std::string seedSelect(const std::string &shape)
+{
+    std::string select = "SELECT i AS id, (i * 7919) % 1000 AS bucket, md5(i::text) AS label, timestamptz '2024-01-01' + i * interval '1 second' AS created";
+    if (shape != "wide")
+        return select;
+
+    for (int k = 1; k <= 6; k++)
+    {
+        select += ", (i * " + std::to_string(k * 31) + ") % 100000 AS int_" + std::to_string(k);
+    }
+    for (int k = 1; k <= 4; k++)
+    {
+        select += ", ((i % 10000) * " + std::to_string(k) + ")::numeric / 100 AS amount_" + std::to_string(k);
+        select += ", sqrt(i * " + std::to_string(k) + ")::float8 AS ratio_" + std::to_string(k);
+    }
+    for (int k = 1; k <= 6; k++)
+    {
+        select += ", repeat(substr(md5((i + " + std::to_string(k) + ")::text), 1, 8), " + std::to_string(k) + ") AS text_" + std::to_string(k);
+    }
+    select += ", i % 3 = 0 AS flag, md5(i::text)::uuid AS uid, date '2020-01-01' + (i % 2000) AS day";
+    select += ", jsonb_build_object('id', i, 'tag', i % 17) AS doc, CASE WHEN i % 10 = 0 THEN NULL ELSE i END AS sparse";
+    return select;
+}
+
+bool seed(PGconn *conn, const Options &options)
+{
+    if (!exec(conn, "CREATE SCHEMA IF NOT EXISTS dbe_bench"))
+        return false;
+
+    for (const auto &shape : options.shapes)
+    {
+        for (int rows : options.sizes)
+        {
+            std::string table = tableName(shape, rows);
+            PGresult *exists = PQexec(conn, ("SELECT to_regclass('" + table + "') IS NOT NULL").c_str());
+            bool present = PQresultStatus(exists) == PGRES_TUPLES_OK && std::string(PQgetvalue(exists, 0, 0)) == "t";
+            PQclear(exists);
+            if (present && !options.reseed)
+                continue;
+
+            std::cerr << "Seeding " << table << std::endl;
+            auto start = Clock::now();
+            bool ok = exec(conn, "DROP TABLE IF EXISTS " + table) && exec(conn, "CREATE TABLE " + table + " AS " + seedSelect(shape) + " FROM generate_series(1, " + std::to_string(rows) + ") AS i") &&
+                      exec(conn, "ALTER TABLE " + table + " ADD PRIMARY KEY (id)") && exec(conn, "CREATE INDEX ON " + table + " (bucket)") && exec(conn, "VACUUM ANALYZE " + table);
+            if (!ok)
+                return false;
+            std::cerr << "Seeded " << table << " in " << static_cast<int>(millisSince(start)) << "ms" << std::endl;
+        }
+    }
+    return true;
+}
+
+// Headless frame: completions are delivered, then the view is laid out exactly as
+// in the application and the draw data is thrown away
+struct Harness
+{
+    ConnectionPool *pool;
+    SchemaCatalog *catalog;
+
+    void frame(Table &table)
+    {
+        pool->poll();
+        catalog->poll();
+
+        ImGuiIO &io = ImGui::GetIO();
+        io.DeltaTime = 1.0f / 60.0f;
+        ImGui::NewFrame();
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(io.DisplaySize);
+        ImGui::Begin("Bench", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
+        table.render();
+        ImGui::End();
+        ImGui::Render();
+    }
+
+    // Renders frames until done() holds; false on timeout
+    bool pump(Table &table, const std::function<bool()> &done, double timeoutMs = 600000)
+    {
+        auto start = Clock::now();
+        while (true)
+        {
+            frame(table);
+            if (done())
+                return true;
+            if (millisSince(start) > timeoutMs)
+                return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+};
+
+// Runs one scenario: setup once, then each iteration is timed and its allocations counted
+Result measure(const std::string &scenario, int iterations, const std::function<bool()> &iteration)
+{
+    Result result;
+    result.scenario = scenario;
+
+    uint64_t traceStart = Trace::now();
+    uint64_t allocations = allocationCount.load();
+    uint64_t bytes = allocatedBytes.load();
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = Clock::now();
+        if (!iteration())
+        {
+            std::cerr << scenario << ": iteration " << i << " did not complete" << std::endl;
+            break;
+        }
+        result.samplesMs.push_back(millisSince(start));
+    }
+
+    size_t samples = std::max<size_t>(1, result.samplesMs.size());
+    result.allocations = (allocationCount.load() - allocations) / samples;
+    result.bytes = (allocatedBytes.load() - bytes) / samples;
+
+    std::vector<Trace::Event> events = Trace::snapshot();
+    events.erase(std::remove_if(events.begin(), events.end(), [traceStart](const Trace::Event &event) { return event.startNs < traceStart; }), events.end());
+    result.spans = Trace::summarize(events);
+    return result;
+}
+
+std::vector<Result> benchmarkTable(Harness &harness, ConnectionPool &pool, PageCache *cache, const SchemaCatalog &catalog, const Options &options, const std::string &shape, int rows)
+{
+    std::vector<Result> results;
+    std::string name = tableName(shape, rows);
+    auto table = std::make_unique<Table>(&pool, cache, &catalog);
+    auto idle = [&table] { return !table->isLoading(); };
+
+    // Opening a table: catalog columns, first page, row estimate
+    results.push_back(measure("open", options.iterations,
+                              [&]
+                              {
+                                  table = std::make_unique<Table>(&pool, cache, &catalog);
+                                  table->loadTableData(name);
+                                  return harness.pump(*table, idle);
+                              }));
+    results.back().unitsPerSample = table->loadedRowCount();
+    results.back().unit = "rows";
+
+    // Keyset pagination forward from the first page
+    results.push_back(measure("next page", std::min(options.iterations, std::max(1, rows / 100 - 1)),
+                              [&]
+                              {
+                                  table->nextPage();
+                                  return harness.pump(*table, idle);
+                              }));
+    results.back().unitsPerSample = table->loadedRowCount();
+    results.back().unit = "rows";
+
+    // Server-side filters: an indexed equality and an unindexed substring search
+    table->loadTableData(name, 0);
+    harness.pump(*table, idle);
+    int bucket = 0;
+    results.push_back(measure("filter equal (indexed)", options.iterations,
+                              [&]
+                              {
+                                  table->setFilter(1, "=" + std::to_string(bucket++ % 1000));
+                                  return harness.pump(*table, idle);
+                              }));
+    table->setFilter(1, "");
+    harness.pump(*table, idle);
+
+    const char *needles[] = {"ab", "c4", "9f", "e1", "77"};
+    int needle = 0;
+    results.push_back(measure("filter contains", options.iterations,
+                              [&]
+                              {
+                                  table->setFilter(2, needles[needle++ % 5]);
+                                  return harness.pump(*table, idle);
+                              }));
+    table->setFilter(2, "");
+    harness.pump(*table, idle);
+
+    // Steady-state frames over a loaded page
+    results.push_back(measure("render frame", options.iterations * 10,
+                              [&]
+                              {
+                                  harness.frame(*table);
+                                  return true;
+                              }));
+
+    // Edits: stage one cell and commit it in a transaction
+    int edit = 0;
+    results.push_back(measure("edit commit", options.iterations,
+                              [&]
+                              {
+                                  table->stageEdit(edit % std::max(1, table->loadedRowCount()), 1, std::to_string(edit % 1000));
+                                  edit++;
+                                  table->commitEdits();
+                                  return harness.pump(*table, [&table] { return !table->isCommitting(); });
+                              }));
+
+    // The edits wrote to bucket, which the filter scenarios read; the seeded values are put back so later runs see the same data
+    bool restored = false;
+    pool.foreground()->submit(&restored,
+                              [name, &restored](PGconn *conn) -> QueryExecutor::Completion
+                              {
+                                  exec(conn, "UPDATE " + name + " SET bucket = (id * 7919) % 1000 WHERE bucket IS DISTINCT FROM (id * 7919) % 1000");
+                                  return [&restored]() { restored = true; };
+                              });
+    harness.pump(*table, [&restored] { return restored; });
+
+    // Streaming every row (up to the resident cap), then sorting what is resident
+    results.push_back(measure("stream all", 1,
+                              [&]
+                              {
+                                  table->setStreaming(true);
+                                  return harness.pump(*table, idle);
+                              }));
+    results.back().unitsPerSample = table->loadedRowCount();
+    results.back().unit = "rows";
+
+    const std::vector<std::vector<RowSorter::Key>> sorts = {{{2, false}}, {{1, true}, {0, false}}, {{3, true}}};
+    int sort = 0;
+    results.push_back(measure("sort resident", std::min(options.iterations, 6),
+                              [&]
+                              {
+                                  table->setSort(sorts[sort++ % sorts.size()]);
+                                  harness.frame(*table);
+                                  return true;
+                              }));
+    results.back().unitsPerSample = table->loadedRowCount();
+    results.back().unit = "rows";
+    table->setStreaming(false);
+    harness.pump(*table, idle);
+
+    for (auto &result : results)
+    {
+        result.table = name;
+        result.shape = shape;
+        result.rows = rows;
+    }
+    return results;
+}
+
+std::string escape(const std::string &text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string toJson(const Options &options, const std::vector<Result> &results)
+{
+    std::ostringstream out;
+    char number[64];
+    auto fixed = [&number](double value)
+    {
+        snprintf(number, sizeof(number), "%.3f", value);
+        return std::string(number);
+    };
+
+    out << "{\n  \"iterations\": " << options.iterations << ",\n  \"cache_mb\": " << options.cacheMb << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &result = results[i];
+        std::vector<double> samples = result.samplesMs;
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double p) { return samples.empty() ? 0.0 : samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+        double total = 0;
+        for (double sample : samples)
+        {
+            total += sample;
+        }
+
+        out << (i ? "," : "") << "\n    {\"table\": \"" << escape(result.table) << "\", \"shape\": \"" << result.shape << "\", \"rows\": " << result.rows << ", \"scenario\": \"" << result.scenario << "\"";
+        out << ", \"samples\": " << samples.size() << ", \"p50_ms\": " << fixed(percentile(0.50)) << ", \"p95_ms\": " << fixed(percentile(0.95)) << ", \"p99_ms\": " << fixed(percentile(0.99)) << ", \"max_ms\": " << fixed(samples.empty() ? 0 : samples.back());
+        out << ", \"throughput\": " << fixed(total > 0 ? samples.size() * result.unitsPerSample * 1000.0 / total : 0) << ", \"throughput_unit\": \"" << result.unit << "/s\"";
+        out << ", \"allocations_per_sample\": " << result.allocations << ", \"allocated_bytes_per_sample\": " << result.bytes;
+        out << ", \"spans\": {";
+        for (size_t s = 0; s < result.spans.size(); s++)
+        {
+            const Trace::Summary &span = result.spans[s];
+            out << (s ? ", " : "") << "\"" << span.category << "." << span.name << "\": {\"count\": " << span.count << ", \"p50_ms\": " << fixed(span.p50Ms) << ", \"p95_ms\": " << fixed(span.p95Ms) << ", \"p99_ms\": " << fixed(span.p99Ms) << "}";
+        }
+        out << "}}";
+    }
+    out << "\n  ]\n}\n";
+    return out.str();
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 2;
+
+    PGconn *conn = PQconnectdb(options.connInfo.c_str());
+    if (PQstatus(conn) != CONNECTION_OK)
+    {
+        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
+        PQfinish(conn);
+        return 1;
+    }
+    if (!seed(conn, options))
+    {
+        PQfinish(conn);
+        return 1;
+    }
+
+    // Headless ImGui: a display size and a built font atlas are all NewFrame() needs
+    IMGUI_CHECKVERSION();
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1920, 1080);
+    io.IniFilename = nullptr;
+    io.Fonts->Build();
+    Trace::setThreadName("main");
+
+    std::vector<Result> results;
+    {
+        ConnectionPool pool(conn, options.connInfo, 3);
+        std::unique_ptr<PageCache> cache = options.cacheMb > 0 ? std::make_unique<PageCache>(static_cast<size_t>(options.cacheMb) << 20) : nullptr;
+        SchemaCatalog catalog(&pool);
+        catalog.load();
+
+        Harness harness{&pool, &catalog};
+        Table warmup(&pool, cache.get(), &catalog);
+        if (!harness.pump(warmup, [&catalog] { return !catalog.isLoading() && catalog.hasDetails(); }, 60000))
+        {
+            std::cerr << "Catalog did not load" << std::endl;
+        }
+
+        for (const auto &shape : options.shapes)
+        {
+            for (int rows : options.sizes)
+            {
+                std::cerr << "Benchmarking " << tableName(shape, rows) << std::endl;
+                std::vector<Result> tableResults = benchmarkTable(harness, pool, cache.get(), catalog, options, shape, rows);
+                results.insert(results.end(), tableResults.begin(), tableResults.end());
+            }
+        }
+    }
+    ImGui::DestroyContext();
+
+    std::string json = toJson(options, results);
+    if (options.output.empty())
+    {
+        std::cout << json;
+    }
+    else if (FILE *file = fopen(options.output.c_str(), "w"))
+    {
+        fputs(json.c_str(), file);
+        fclose(file);
+    }
+    else
+    {
+        std::cerr << "Could not write " << options.output << std::endl;
+        return 1;
+    }
+    return 0;
+}
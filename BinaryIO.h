@@ -0,0 +1,103 @@
+#pragma once
+
+// Standard library includes
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Flat binary records for the disk cache. Scalars and arrays of trivially
+// copyable values are written in host byte order and arrays as one block, so a
+// column is read back with a single memcpy; a cache file is only ever read on the
+// machine that wrote it. The reader checks every length against the bytes left
+// and stops at the first inconsistency, so a truncated or foreign file fails
+// cleanly instead of being trusted.
+class BinaryWriter
+{
+  public:
+    explicit BinaryWriter(std::string &out) : out(out) {}
+
+    template <typename T> void value(const T &value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are written directly");
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void bytes(std::string_view data)
+    {
+        value<uint64_t>(data.size());
+        out.append(data.data(), data.size());
+    }
+
+    template <typename T> void array(const std::vector<T> &values)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values are written directly");
+        value<uint64_t>(values.size());
+        out.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+    }
+
+  private:
+    std::string &out;
+};
+
+class BinaryReader
+{
+  public:
+    explicit BinaryReader(std::string_view data) : data(data) {}
+
+    template <typename T> bool value(T &value)
+    {
+        if (data.size() < sizeof(T))
+            return fail();
+        std::memcpy(&value, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    // The view points into the reader's input
+    bool bytes(std::string_view &view)
+    {
+        uint64_t size = 0;
+        if (!value(size) || size > data.size())
+            return fail();
+        view = data.substr(0, size);
+        data.remove_prefix(size);
+        return true;
+    }
+
+    bool bytes(std::string &text)
+    {
+        std::string_view view;
+        if (!bytes(view))
+            return false;
+        text.assign(view);
+        return true;
+    }
+
+    template <typename T> bool array(std::vector<T> &values)
+    {
+        uint64_t count = 0;
+        if (!value(count) || count > data.size() / sizeof(T))
+            return fail();
+        values.resize(count);
+        std::memcpy(values.data(), data.data(), count * sizeof(T));
+        data.remove_prefix(count * sizeof(T));
+        return true;
+    }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return data.empty(); }
+
+  private:
+    std::string_view data;
+    bool failed = false;
+
+    bool fail()
+    {
+        failed = true;
+        data = {};
+        return false;
+    }
+};
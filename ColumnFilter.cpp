@@ -0,0 +1,473 @@
+#include "ColumnFilter.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+constexpr Oid TextOid = 25;
+
+std::string trim(const std::string &text)
+{
+    size_t begin = text.find_first_not_of(" \t");
+    size_t end = text.find_last_not_of(" \t");
+    return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+std::string lower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+// Reads exactly count digits at pos into value
+bool digits(const std::string &text, size_t &pos, size_t count, int &value)
+{
+    if (pos + count > text.size())
+        return false;
+    value = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        char c = text[pos + i];
+        if (!std::isdigit(static_cast<unsigned char>(c)))
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    pos += count;
+    return true;
+}
+
+bool skip(const std::string &text, size_t &pos, char c)
+{
+    if (pos >= text.size() || text[pos] != c)
+        return false;
+    pos++;
+    return true;
+}
+
+// YYYY-MM-DD with a day that exists in that month
+bool parseDate(const std::string &text, size_t &pos)
+{
+    static const int monthDays[] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (!digits(text, pos, 4, year) || !skip(text, pos, '-') || !digits(text, pos, 2, month) || !skip(text, pos, '-') || !digits(text, pos, 2, day))
+        return false;
+    if (month < 1 || month > 12 || day < 1 || day > monthDays[month - 1])
+        return false;
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month != 2 || day <= 28 || leap;
+}
+
+// HH:MM with optional :SS and fraction
+bool parseTime(const std::string &text, size_t &pos)
+{
+    int hour = 0;
+    int minute = 0;
+    int second = 0;
+    if (!digits(text, pos, 2, hour) || !skip(text, pos, ':') || !digits(text, pos, 2, minute) || hour > 24 || minute > 59)
+        return false;
+    if (skip(text, pos, ':'))
+    {
+        if (!digits(text, pos, 2, second) || second > 60)
+            return false;
+        if (skip(text, pos, '.') && !(pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos]))))
+            return false;
+        while (pos < text.size() && std::isdigit(static_cast<unsigned char>(text[pos])))
+        {
+            pos++;
+        }
+    }
+    return true;
+}
+
+// Z, or +HH, +HHMM, +HH:MM and the same with a minus, optionally after a space
+bool parseZone(const std::string &text, size_t &pos)
+{
+    size_t start = pos;
+    skip(text, pos, ' ');
+    if (skip(text, pos, 'Z') || skip(text, pos, 'z'))
+        return true;
+    int hour = 0;
+    int minute = 0;
+    if (!(skip(text, pos, '+') || skip(text, pos, '-')) || !digits(text, pos, 2, hour))
+    {
+        pos = start;
+        return false;
+    }
+    size_t colon = pos;
+    if (skip(text, pos, ':') || pos < text.size())
+    {
+        if (!digits(text, pos, 2, minute))
+        {
+            pos = colon;
+        }
+    }
+    if (hour > 15 || minute > 59)
+    {
+        pos = start;
+        return false;
+    }
+    return true;
+}
+
+// A quantity with a unit, e.g. "1 day 2 hours", or a time of day, optionally ending in "ago"
+bool isInterval(const std::string &folded)
+{
+    static const char *units[] = {"microsecond", "microseconds", "us",   "millisecond", "milliseconds", "ms",     "second",  "seconds",   "sec",        "secs",     "s",
+                                  "minute",      "minutes",      "min",  "mins",        "m",            "hour",   "hours",   "hr",        "hrs",        "h",        "day",
+                                  "days",        "d",            "week", "weeks",       "w",            "month",  "months",  "mon",       "mons",       "year",     "years",
+                                  "yr",          "yrs",          "y",    "decade",      "decades",      "century", "centuries", "millennium", "millennia"};
+    size_t pos = 0;
+    bool quantity = false;
+    while (pos < folded.size())
+    {
+        while (pos < folded.size() && folded[pos] == ' ')
+        {
+            pos++;
+        }
+        if (pos == folded.size())
+            break;
+
+        size_t start = pos;
+        if (folded[pos] == '+' || folded[pos] == '-')
+        {
+            pos++;
+        }
+        size_t number = pos;
+        if (parseTime(folded, pos))
+        {
+            quantity = true;
+            continue;
+        }
+        pos = number;
+        while (pos < folded.size() && (std::isdigit(static_cast<unsigned char>(folded[pos])) || folded[pos] == '.'))
+        {
+            pos++;
+        }
+        if (pos == number)
+        {
+            // Only a trailing "ago" may stand without a number
+            return quantity && start == pos && folded.compare(pos, std::string::npos, "ago") == 0;
+        }
+
+        while (pos < folded.size() && folded[pos] == ' ')
+        {
+            pos++;
+        }
+        size_t unitStart = pos;
+        while (pos < folded.size() && std::isalpha(static_cast<unsigned char>(folded[pos])))
+        {
+            pos++;
+        }
+        // A bare number at the end counts seconds
+        std::string unit = folded.substr(unitStart, pos - unitStart);
+        if (unit.empty() && pos == folded.size())
+            return true;
+        if (std::none_of(std::begin(units), std::end(units), [&](const char *name) { return unit == name; }))
+            return false;
+        quantity = true;
+    }
+    return quantity;
+}
+} // namespace
+
+ColumnFilter::ColumnFilter(const std::string &text, Oid type) : type(type), typeClass(classify(type))
+{
+    std::string filter = trim(text);
+    if (filter.empty())
+        return;
+
+    std::string folded = lower(filter);
+    if (folded == "null")
+    {
+        operation = Op::IsNull;
+        return;
+    }
+    if (folded == "!null" || folded == "not null")
+    {
+        operation = Op::NotNull;
+        return;
+    }
+
+    // Longer operators are matched first so ">=" is not read as ">" followed by "="
+    static const std::pair<const char *, Op> operators[] = {{">=", Op::GreaterEqual}, {"<=", Op::LessEqual}, {"!=", Op::NotEqual}, {"<>", Op::NotEqual}, {">", Op::Greater}, {"<", Op::Less}, {"=", Op::Equal}};
+    for (const auto &entry : operators)
+    {
+        size_t length = strlen(entry.first);
+        if (filter.compare(0, length, entry.first) == 0)
+        {
+            operation = entry.second;
+            first = trim(filter.substr(length));
+            break;
+        }
+    }
+
+    size_t dots = filter.find("..");
+    if (operation == Op::None && dots != std::string::npos && (typeClass == TypeClass::Number || typeClass == TypeClass::Temporal))
+    {
+        operation = Op::Range;
+        first = trim(filter.substr(0, dots));
+        second = trim(filter.substr(dots + 2));
+    }
+    else if (operation == Op::None && typeClass == TypeClass::Text && filter.size() > 1 && filter.back() == '*')
+    {
+        operation = Op::Prefix;
+        first = filter.substr(0, filter.size() - 1);
+    }
+    else if (operation == Op::None)
+    {
+        operation = typeClass == TypeClass::Text || typeClass == TypeClass::Other ? Op::Contains : Op::Equal;
+        first = filter;
+    }
+
+    // Anything the column's type cannot take (or a type without comparisons) is searched as text instead
+    bool typed = operation != Op::Contains && operation != Op::Prefix;
+    if (typed && (typeClass == TypeClass::Other || !accepts(first) || (operation == Op::Range && !accepts(second))))
+    {
+        operation = Op::Contains;
+        first = filter;
+        second.clear();
+    }
+}
+
+ColumnFilter::Plan ColumnFilter::plan(const SchemaCatalog::Relation *relation, int col) const
+{
+    Plan result;
+    if (!relation || operation == Op::None)
+        return result;
+
+    for (const auto &index : relation->indexes)
+    {
+        auto position = std::find(index.columns.begin(), index.columns.end(), col);
+        if (index.partial || position == index.columns.end())
+            continue;
+
+        size_t key = position - index.columns.begin();
+        const std::string opclass = key < index.opclasses.size() ? index.opclasses[key] : "";
+        bool trigram = opclass == "gin_trgm_ops" || opclass == "gist_trgm_ops";
+        bool leading = key == 0 && (index.method == "btree" || index.method == "hash");
+        bool pattern = opclass.find("_pattern_ops") != std::string::npos;
+        bool ordered = leading && index.method == "btree" && !pattern;
+
+        bool serves = false;
+        switch (operation)
+        {
+        case Op::Contains:
+            serves = trigram && typeClass == TypeClass::Text;
+            break;
+        case Op::Prefix:
+            serves = trigram || (leading && pattern);
+            break;
+        case Op::Equal:
+            serves = leading;
+            break;
+        case Op::Less:
+        case Op::LessEqual:
+        case Op::Greater:
+        case Op::GreaterEqual:
+        case Op::Range:
+        case Op::IsNull:
+            serves = ordered;
+            break;
+        default:
+            break;
+        }
+
+        if (serves)
+        {
+            result.indexed = true;
+            result.trigram = trigram;
+            result.index = index.name;
+            break;
+        }
+    }
+    return result;
+}
+
+std::string ColumnFilter::buildPredicate(const std::string &column, SqlQuery &query, const Plan &plan) const
+{
+    switch (operation)
+    {
+    case Op::IsNull:
+        return column + " IS NULL";
+    case Op::NotNull:
+        return column + " IS NOT NULL";
+    case Op::Contains:
+        if (plan.trigram)
+            return column + " ILIKE " + query.bind("%" + escapeLike(first) + "%", TextOid);
+        return "strpos(lower(" + column + "::text), lower(" + query.bind(first, TextOid) + ")) > 0";
+    case Op::Prefix:
+        return column + " LIKE " + query.bind(escapeLike(first) + "%", TextOid);
+    case Op::Equal:
+        return column + " = " + query.bind(first, type);
+    case Op::NotEqual:
+        return column + " <> " + query.bind(first, type);
+    case Op::Less:
+        return column + " < " + query.bind(first, type);
+    case Op::LessEqual:
+        return column + " <= " + query.bind(first, type);
+    case Op::Greater:
+        return column + " > " + query.bind(first, type);
+    case Op::GreaterEqual:
+        return column + " >= " + query.bind(first, type);
+    case Op::Range:
+    {
+        // Bound in sequence so the placeholders number in the order they appear
+        std::string low = query.bind(first, type);
+        return column + " BETWEEN " + low + " AND " + query.bind(second, type);
+    }
+    default:
+        return "TRUE";
+    }
+}
+
+std::string ColumnFilter::describe(const Plan &plan) const
+{
+    static const char *names[] = {"", "contains", "starts with (case-sensitive)", "=", "!=", "<", "<=", ">", ">=", "between", "is null", "is not null"};
+    std::string text = names[static_cast<int>(operation)];
+    if (operation == Op::Range)
+    {
+        text += " " + first + " and " + second;
+    }
+    else if (operation != Op::IsNull && operation != Op::NotNull)
+    {
+        text += " '" + first + "'";
+    }
+    return text + (plan.indexed ? ": can use index " + plan.index : ": sequential scan");
+}
+
+ColumnFilter::TypeClass ColumnFilter::classify(Oid type)
+{
+    switch (type)
+    {
+    case 25:   // text
+    case 1043: // varchar
+    case 1042: // bpchar
+    case 19:   // name
+        return TypeClass::Text;
+    case 20:   // int8
+    case 21:   // int2
+    case 23:   // int4
+    case 26:   // oid
+    case 700:  // float4
+    case 701:  // float8
+    case 1700: // numeric
+        return TypeClass::Number;
+    case 1082: // date
+    case 1083: // time
+    case 1114: // timestamp
+    case 1184: // timestamptz
+    case 1186: // interval
+    case 1266: // timetz
+        return TypeClass::Temporal;
+    case 16: // bool
+        return TypeClass::Boolean;
+    case 2950: // uuid
+        return TypeClass::Uuid;
+    default:
+        return TypeClass::Other;
+    }
+}
+
+bool ColumnFilter::accepts(const std::string &value) const
+{
+    // A light check so a half-typed value searches as text instead of failing the whole query
+    if (value.empty())
+        return false;
+
+    std::string folded = lower(value);
+    switch (typeClass)
+    {
+    case TypeClass::Number:
+    {
+        // Integer columns reject fractions, and every type rejects values outside its range, both of which the server would refuse
+        char *end = nullptr;
+        errno = 0;
+        if (type == 20 || type == 21 || type == 23 || type == 26)
+        {
+            long long number = std::strtoll(value.c_str(), &end, 10);
+            if (*end != '\0' || errno == ERANGE)
+                return false;
+            if (type == 21)
+                return number >= std::numeric_limits<int16_t>::min() && number <= std::numeric_limits<int16_t>::max();
+            if (type == 23)
+                return number >= std::numeric_limits<int32_t>::min() && number <= std::numeric_limits<int32_t>::max();
+            if (type == 26)
+                return number >= 0 && number <= std::numeric_limits<uint32_t>::max();
+            return true;
+        }
+        if (folded == "nan" || folded == "infinity" || folded == "-infinity")
+            return true;
+
+        // numeric holds far larger exponents than a double, so only the float types are held to one
+        if (type == 700)
+            std::strtof(value.c_str(), &end);
+        else
+            std::strtod(value.c_str(), &end);
+        return *end == '\0' && (type == 1700 || errno != ERANGE);
+    }
+    case TypeClass::Temporal:
+    {
+        // The whole value must have the type's ISO shape; a partial date such as 2024-01 is searched as text
+        size_t pos = 0;
+        switch (type)
+        {
+        case 1082: // date
+            return folded == "infinity" || folded == "-infinity" || folded == "today" || folded == "yesterday" || folded == "tomorrow" || folded == "epoch" ||
+                   (parseDate(value, pos) && pos == value.size());
+        case 1114: // timestamp
+        case 1184: // timestamptz
+            if (folded == "infinity" || folded == "-infinity" || folded == "now" || folded == "today" || folded == "yesterday" || folded == "tomorrow" || folded == "epoch")
+                return true;
+            if (!parseDate(value, pos))
+                return false;
+            if ((skip(value, pos, 'T') || skip(value, pos, 't') || skip(value, pos, ' ')) && !parseTime(value, pos))
+                return false;
+            parseZone(value, pos);
+            return pos == value.size();
+        case 1083: // time
+        case 1266: // timetz
+            if (folded == "now" || folded == "allballs")
+                return true;
+            if (!parseTime(value, pos))
+                return false;
+            parseZone(value, pos);
+            return pos == value.size();
+        default: // interval
+            return isInterval(folded);
+        }
+    }
+    case TypeClass::Boolean:
+        return folded == "t" || folded == "f" || folded == "true" || folded == "false" || folded == "yes" || folded == "no" || folded == "on" || folded == "off" || folded == "1" || folded == "0";
+    case TypeClass::Uuid:
+    {
+        int digits = static_cast<int>(std::count_if(value.begin(), value.end(), [](unsigned char c) { return std::isxdigit(c); }));
+        return digits == 32 && std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isxdigit(c) || c == '-' || c == '{' || c == '}'; });
+    }
+    case TypeClass::Text:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string ColumnFilter::escapeLike(const std::string &value)
+{
+    // Backslash is LIKE's default escape character
+    std::string escaped;
+    for (char c : value)
+    {
+        if (c == '%' || c == '_' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
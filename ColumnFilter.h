@@ -0,0 +1,89 @@
+#pragma once
+
+// Standard library includes
+#include <string>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "QueryExecutor.h"
+#include "SchemaCatalog.h"
+
+// One column's filter text parsed into a predicate chosen by the column's type:
+//
+//   value         equality for numbers, dates, times, booleans and uuids;
+//                 a case-insensitive substring match for text
+//   =v  !=v       equality, inequality
+//   >v >=v <v <=v comparisons
+//   a..b          inclusive range
+//   abc*          case-sensitive prefix match (text)
+//   null  !null   IS NULL, IS NOT NULL
+//
+// Values are bound with the column's own type, so comparisons are native and a
+// btree index on the column can serve them. Prefix matches use LIKE, which a
+// btree with text_pattern_ops (or a trigram index) can serve; they are left
+// case-sensitive because a btree cannot serve ILIKE. Substring matches ignore
+// case, using ILIKE only when a pg_trgm index exists and otherwise a plain
+// strpos scan. A value that does not have the column type's full shape (an ISO
+// date for a date, for example) falls back to a substring match on the column's
+// text.
+class ColumnFilter
+{
+  public:
+    enum class Op
+    {
+        None,
+        Contains,
+        Prefix,
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Range,
+        IsNull,
+        NotNull
+    };
+
+    // How the server can evaluate the predicate, judged from the catalog's indexes
+    struct Plan
+    {
+        bool indexed = false;
+        bool trigram = false;
+        std::string index; // Name of the index that can serve the predicate
+    };
+
+    // Constructor
+    ColumnFilter() = default;
+    ColumnFilter(const std::string &text, Oid type);
+
+    // Main public interface
+    Op op() const { return operation; }
+    const std::string &value() const { return first; }
+    Plan plan(const SchemaCatalog::Relation *relation, int col) const;
+    std::string buildPredicate(const std::string &column, SqlQuery &query, const Plan &plan) const;
+    std::string describe(const Plan &plan) const;
+
+  private:
+    enum class TypeClass
+    {
+        Text,
+        Number,
+        Temporal,
+        Boolean,
+        Uuid,
+        Other
+    };
+
+    Op operation = Op::None;
+    std::string first;
+    std::string second;
+    Oid type = 0;
+    TypeClass typeClass = TypeClass::Other;
+
+    static TypeClass classify(Oid type);
+    bool accepts(const std::string &value) const;
+    static std::string escapeLike(const std::string &value);
+};
@@ -0,0 +1,99 @@
+#include "ConnectionPool.h"
+#include <algorithm>
+
+namespace
+{
+constexpr auto HealthCheckInterval = std::chrono::seconds(30);
+} // namespace
+
+ConnectionPool::ConnectionPool(PGconn *primary, const std::string &connInfo, int size) : connInfo(connInfo), targetSize(1)
+{
+    executors.push_back(std::make_unique<QueryExecutor>(primary, connInfo));
+    resize(size);
+}
+
+QueryExecutor *ConnectionPool::background()
+{
+    if (executors.size() == 1)
+    {
+        return foreground();
+    }
+
+    // Least loaded background connection; the foreground one is never chosen
+    auto best = std::min_element(executors.begin() + 1, executors.end(), [](const auto &a, const auto &b) { return a->pendingJobs() < b->pendingJobs(); });
+    return best->get();
+}
+
+void ConnectionPool::poll()
+{
+    for (auto &executor : executors)
+    {
+        executor->poll();
+    }
+    trim();
+
+    if (Clock::now() - lastHealthCheck < HealthCheckInterval)
+        return;
+
+    lastHealthCheck = Clock::now();
+    for (auto &executor : executors)
+    {
+        if (!executor->isBusy())
+        {
+            executor->checkHealth();
+        }
+    }
+}
+
+void ConnectionPool::discard(const void *owner)
+{
+    for (auto &executor : executors)
+    {
+        executor->discard(owner);
+    }
+}
+
+void ConnectionPool::cancel(const void *owner)
+{
+    for (auto &executor : executors)
+    {
+        executor->cancel(owner);
+    }
+}
+
+void ConnectionPool::setStatementTimeout(int milliseconds)
+{
+    statementTimeout = milliseconds;
+    for (auto &executor : executors)
+    {
+        executor->setStatementTimeout(milliseconds);
+    }
+}
+
+void ConnectionPool::resize(int size)
+{
+    targetSize = std::max(size, 1);
+
+    // New connections are opened by their own worker, so growing never blocks the UI
+    while (static_cast<int>(executors.size()) < targetSize)
+    {
+        executors.push_back(std::make_unique<QueryExecutor>(nullptr, connInfo));
+        executors.back()->setStatementTimeout(statementTimeout);
+    }
+    trim();
+}
+
+int ConnectionPool::healthyCount() const
+{
+    return static_cast<int>(std::count_if(executors.begin(), executors.end(), [](const auto &executor) { return executor->isHealthy(); }));
+}
+
+void ConnectionPool::trim()
+{
+    // Only idle connections are closed; busy ones are retried on a later poll instead of blocking on their job
+    while (static_cast<int>(executors.size()) > targetSize && !executors.back()->isBusy())
+    {
+        executors.back()->poll();
+        executors.pop_back();
+    }
+}
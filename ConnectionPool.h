@@ -0,0 +1,52 @@
+#pragma once
+
+// Standard library includes
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "QueryExecutor.h"
+
+// A small set of connections, each driven by its own QueryExecutor. The first
+// connection serves the page being browsed and edits; prefetch, counts and
+// other background jobs go to the least loaded of the others, so a slow job
+// never queues in front of the visible page. Idle connections are checked
+// periodically and reconnect on their own when found broken. Session settings
+// are held here so connections opened later pick them up too.
+class ConnectionPool
+{
+  public:
+    // Constructor
+    ConnectionPool(PGconn *primary, const std::string &connInfo, int size);
+
+    // Main public interface
+    QueryExecutor *foreground() { return executors.front().get(); }
+    QueryExecutor *background();
+    void poll();
+    void discard(const void *owner);
+    void cancel(const void *owner);
+    void resize(int size);
+    void setStatementTimeout(int milliseconds);
+
+    // Status
+    int size() const { return static_cast<int>(executors.size()); }
+    int healthyCount() const;
+    const std::string &connectionInfo() const { return connInfo; }
+    const QueryExecutor &executor(int index) const { return *executors[index]; }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string connInfo;
+    std::vector<std::unique_ptr<QueryExecutor>> executors;
+    int targetSize;
+    int statementTimeout = -1;
+    Clock::time_point lastHealthCheck = Clock::now();
+
+    void trim();
+};
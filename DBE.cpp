@@ -1,18 +1,40 @@
 #define GL_SILENCE_DEPRECATION
 #include "DBE.h"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 
 DBE::~DBE() { shutdown(); }
 
+bool DBE::isWorking() const
+{
+    return std::any_of(dbState.tabs.begin(), dbState.tabs.end(), [](const TableTab &tab) { return tab.view->isWorking(); });
+}
+
 void DBE::render()
 {
+    // Hand finished queries back to their owners before anything is drawn
+    if (dbState.pool)
+    {
+        dbState.pool->poll();
+        dbState.catalog->poll();
+    }
+
     renderConnectionBar();
     if (dbState.isConnected())
     {
         renderConnectionInfo();
     }
     renderContent();
+
+    if (ImGui::IsKeyPressed(ImGuiKey_F12, false))
+    {
+        showLatency = !showLatency;
+    }
+    if (showLatency)
+    {
+        renderLatencyOverlay();
+    }
 }
 
 void DBE::renderConnectionBar()
@@ -76,16 +98,177 @@ void DBE::renderConnectionInfo()
 
     ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
 
-    std::string connInfo = "User: " + dbState.connectedUser + "  |  Port: " + dbState.connectedPort + "  |  Conn Time: " + std::to_string(static_cast<int>(dbState.connectionTimeMs)) + "ms" + "  |  Host: " + dbState.connectedHost;
-
     ImGui::SetCursorPos(ImVec2(10, 4));
-    ImGui::Text("%s", connInfo.c_str());
+    ImGui::Text("User: %s  |  Port: %s  |  Conn Time: %dms  |  Host: %s", dbState.connectedUser.c_str(), dbState.connectedPort.c_str(), static_cast<int>(dbState.connectionTimeMs), dbState.connectedHost.c_str());
+
+    if (dbState.pool)
+    {
+        const StatementCache &statements = dbState.pool->foreground()->statements();
+        uint64_t executions = statements.hitCount() + statements.missCount();
+        ImGui::SameLine();
+        ImGui::Text("  |  Statements: %d prepared, %d%% reused, %.1fms preparing", static_cast<int>(statements.size()), executions ? static_cast<int>(statements.hitCount() * 100 / executions) : 0, statements.prepareMillis());
+
+        const SchemaCatalog &catalog = *dbState.catalog;
+        ImGui::SameLine();
+        if (catalog.isLoading())
+        {
+            ImGui::Text("  |  Catalog: %d relations listed in %dms, loading columns...", catalog.relationCount(), static_cast<int>(catalog.namesMillis()));
+        }
+        else
+        {
+            ImGui::Text("  |  Catalog: %d relations in %dms", catalog.relationCount(), static_cast<int>(catalog.loadMillis()));
+        }
+
+        ImGui::SameLine();
+        ImGui::Text("  |  Pool: %d/%d healthy, size:", dbState.pool->healthyCount(), dbState.pool->size());
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(30);
+        ImGui::SetCursorPosY(1);
+        if (ImGui::InputInt("##PoolSize", &dbState.poolSize, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+        {
+            dbState.poolSize = std::clamp(dbState.poolSize, 1, 16);
+            dbState.pool->resize(dbState.poolSize);
+        }
+
+        ImGui::SameLine();
+        ImGui::Text("  |  Timeout s:");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(40);
+        ImGui::SetCursorPosY(1);
+        if (ImGui::InputInt("##StatementTimeout", &dbState.statementTimeoutSec, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+        {
+            dbState.statementTimeoutSec = std::clamp(dbState.statementTimeoutSec, 0, 86400);
+            dbState.pool->setStatementTimeout(dbState.statementTimeoutSec * 1000);
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("statement_timeout for browsing queries and counts, 0 for none; exports and imports are not limited");
+        }
+    }
+
+    if (dbState.pageCache)
+    {
+        const PageCache &cache = *dbState.pageCache;
+        uint64_t lookups = cache.hitCount() + cache.missCount();
+        ImGui::SameLine();
+        ImGui::Text("  |  Page Cache: %.1f MB, %d%% hits  |  Budget MB:", cache.memoryBytes() / (1024.0 * 1024.0), lookups ? static_cast<int>(cache.hitCount() * 100 / lookups) : 0);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60);
+        ImGui::SetCursorPosY(1);
+        if (ImGui::InputInt("##CacheBudget", &dbState.pageCacheMb, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+        {
+            dbState.pageCacheMb = std::max(dbState.pageCacheMb, 0);
+            dbState.pageCache->setBudget(static_cast<size_t>(dbState.pageCacheMb) << 20);
+        }
+    }
+
+    if (dbState.pool)
+    {
+        ImGui::SameLine();
+        ImGui::Text("  |  Views: %d, %.1f MB  |  Budget MB:", static_cast<int>(dbState.tabs.size()), viewMemoryBytes() / (1024.0 * 1024.0));
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60);
+        ImGui::SetCursorPosY(1);
+        if (ImGui::InputInt("##ViewBudget", &dbState.viewBudgetMb, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+        {
+            dbState.viewBudgetMb = std::max(dbState.viewBudgetMb, 0);
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Rows held by all open tabs; hidden tabs shown least recently give theirs back first");
+        }
+    }
+
+    if (dbState.diskCache)
+    {
+        const DiskCache &disk = *dbState.diskCache;
+        ImGui::SameLine();
+        ImGui::Text("  |");
+        ImGui::SameLine();
+        ImGui::SetCursorPosY(1);
+        if (ImGui::Checkbox("Disk Cache", &dbState.useDiskCache) && !dbState.useDiskCache)
+        {
+            dbState.diskCache->erase();
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Keep the catalog and recent pages in %s\nRestored %d pages, %d stale tables%s", disk.path().c_str(), disk.restoredPages(), disk.staleTables(), disk.isRevalidating() ? ", revalidating..." : "");
+        }
+    }
+
+    ImGui::SameLine();
+    ImGui::SetCursorPosY(3);
+    if (ImGui::SmallButton("Latency"))
+    {
+        showLatency = !showLatency;
+    }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Show query and frame timings (F12)");
+    }
 
     ImGui::PopStyleColor();
     ImGui::EndChild();
     ImGui::PopStyleVar();
 }
 
+void DBE::renderLatencyOverlay()
+{
+    if (ImGui::GetTime() - latencyUpdated >= 0.5 || latencyUpdated < 0)
+    {
+        latencySummaries = Trace::summarize(Trace::snapshot());
+        latencyUpdated = ImGui::GetTime();
+    }
+
+    const ImGuiViewport *viewport = ImGui::GetMainViewport();
+    ImGui::SetNextWindowPos(ImVec2(viewport->WorkPos.x + viewport->WorkSize.x - 20, viewport->WorkPos.y + 90), ImGuiCond_FirstUseEver, ImVec2(1, 0));
+    ImGui::SetNextWindowBgAlpha(0.9f);
+    if (!ImGui::Begin("Latency", &showLatency, ImGuiWindowFlags_AlwaysAutoResize))
+    {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::TextDisabled("Send, server and transfer split each query; decode is result parsing, frame the CPU time per frame");
+    if (ImGui::BeginTable("##LatencyTable", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit))
+    {
+        const char *headers[] = {"Category", "Span", "Count", "p50 ms", "p95 ms", "p99 ms", "Max ms"};
+        for (const char *header : headers)
+        {
+            ImGui::TableSetupColumn(header);
+        }
+        ImGui::TableHeadersRow();
+
+        for (const auto &summary : latencySummaries)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextDisabled("%s", summary.category);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", summary.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", static_cast<int>(summary.count));
+            for (double value : {summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs})
+            {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", value);
+            }
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::Button("Export Chrome Trace"))
+    {
+        std::string path = "dbe-trace-" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())) + ".json";
+        traceStatus = Trace::exportChromeTrace(path) ? "Wrote " + path + ", open it in chrome://tracing or ui.perfetto.dev" : "Could not write " + path;
+        std::cout << traceStatus << std::endl;
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", traceStatus.empty() ? "Keeps the most recent 16384 spans" : traceStatus.c_str());
+
+    ImGui::End();
+}
+
 void DBE::renderContent()
 {
     ImGui::BeginChild("Content", ImVec2(0, 0), false);
@@ -102,117 +285,371 @@ void DBE::renderContent()
 
 void DBE::renderLeftPanel()
 {
+    SchemaCatalog &catalog = *dbState.catalog;
+
     ImGui::BeginChild("LeftPanel", ImVec2(200, 0), true);
     ImGui::Text("Tables");
+    ImGui::SameLine();
+    ImGui::TextDisabled("%d", catalog.relationCount());
+    ImGui::SameLine();
+    ImGui::BeginDisabled(catalog.isLoading() || catalog.isRefreshing());
+    if (ImGui::SmallButton("Refresh"))
+    {
+        catalog.refresh();
+    }
+    ImGui::EndDisabled();
     ImGui::Separator();
     ImGui::Dummy(ImVec2(0, 2.0f));
 
-    for (const auto &table : dbState.tables)
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    if (ImGui::InputTextWithHint("##TableFilter", "Filter tables...", dbState.tableFilter, sizeof(dbState.tableFilter)))
+    {
+        panelDirty = true;
+    }
+
+    if (catalog.relationCount() == 0 && catalog.isLoading())
+    {
+        ImGui::TextDisabled("Loading...");
+    }
+
+    if (panelDirty || panelVersion != catalog.version())
     {
-        if (ImGui::Selectable(table.c_str(), dbState.selectedTable == table))
+        rebuildPanelRows();
+    }
+
+    // Only the rows in view are submitted, so the panel costs the same for 40 tables or 40,000
+    ImGui::BeginChild("TableList", ImVec2(0, 0), false);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(panelRows.size()));
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
         {
-            dbState.selectedTable = table;
+            const PanelRow &row = panelRows[i];
+            ImGui::PushID(i);
+            if (row.relation < 0)
+            {
+                const std::string &schema = catalog.schemas()[row.schema].name;
+                bool collapsed = dbState.tableFilter[0] == '\0' && dbState.collapsedSchemas.count(schema) > 0;
+                ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+                if (ImGui::Selectable(((collapsed ? "+ " : "- ") + schema).c_str()))
+                {
+                    if (!dbState.collapsedSchemas.erase(schema))
+                    {
+                        dbState.collapsedSchemas.insert(schema);
+                    }
+                    panelDirty = true;
+                }
+                ImGui::PopStyleColor();
+            }
+            else
+            {
+                const SchemaCatalog::Relation &relation = catalog.relation(row.relation);
+                ImGui::Indent(8.0f);
+                if (ImGui::Selectable(relation.name.c_str(), dbState.selectedTable == relation.qualifiedName))
+                {
+                    dbState.selectedTable = relation.qualifiedName;
+                }
+                ImGui::Unindent(8.0f);
+            }
+            ImGui::PopID();
         }
     }
+    ImGui::EndChild();
 
     ImGui::EndChild();
 }
 
+void DBE::rebuildPanelRows()
+{
+    const SchemaCatalog &catalog = *dbState.catalog;
+    std::string filter = dbState.tableFilter;
+    std::transform(filter.begin(), filter.end(), filter.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    panelRows.clear();
+    const auto &schemas = catalog.schemas();
+    for (int schema = 0; schema < static_cast<int>(schemas.size()); schema++)
+    {
+        // While filtering every schema is expanded, and schemas without a match are hidden
+        bool collapsed = filter.empty() && dbState.collapsedSchemas.count(schemas[schema].name) > 0;
+        size_t header = panelRows.size();
+        panelRows.push_back({schema, -1});
+        if (collapsed)
+            continue;
+
+        for (int index : schemas[schema].relations)
+        {
+            const std::string &name = catalog.relation(index).name;
+            auto match = std::search(name.begin(), name.end(), filter.begin(), filter.end(), [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+            if (match != name.end() || filter.empty())
+            {
+                panelRows.push_back({schema, index});
+            }
+        }
+        if (!filter.empty() && panelRows.size() == header + 1)
+        {
+            panelRows.resize(header);
+        }
+    }
+
+    panelVersion = catalog.version();
+    panelDirty = false;
+}
+
 void DBE::renderMainPanel()
 {
     ImGui::BeginChild("MainPanel", ImVec2(0, 0), false);
 
-    if (!dbState.selectedTable.empty() && dbState.tableView)
+    // A table picked in the meantime wins over the last one; a table the finished load does not list is dropped
+    if (!dbState.pendingTable.empty())
     {
-        ImGui::Dummy(ImVec2(0, 4.0f));
-
-        std::string title = dbState.selectedTable;
-        if (!title.empty())
+        if (dbState.selectedTable.empty() && dbState.catalog->find(dbState.pendingTable))
+        {
+            dbState.selectedTable = dbState.pendingTable;
+            dbState.pendingTable.clear();
+        }
+        else if (!dbState.selectedTable.empty() || !dbState.catalog->isLoading())
         {
-            title[0] = std::toupper(title[0]);
+            dbState.pendingTable.clear();
         }
-        title += " Table";
+    }
 
-        ImGui::Text("%s", title.c_str());
-        ImGui::Separator();
-        ImGui::Dummy(ImVec2(0, 2.0f));
+    // Picking a table in the left panel opens it in a new tab, or brings its tab forward
+    if (!dbState.selectedTable.empty() && dbState.selectedTable != dbState.activeTab)
+    {
+        openTable(dbState.selectedTable);
+    }
+    enforceViewBudget();
 
-        static std::string lastTable;
-        if (lastTable != dbState.selectedTable)
+    if (!dbState.tabs.empty() && ImGui::BeginTabBar("##TableTabs", ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_FittingPolicyScroll))
+    {
+        for (size_t i = 0; i < dbState.tabs.size();)
         {
-            dbState.tableView->loadTableData(dbState.selectedTable, 0);
-            lastTable = dbState.selectedTable;
+            TableTab &tab = dbState.tabs[i];
+            const SchemaCatalog::Relation *relation = dbState.catalog->find(tab.name);
+
+            // The ID after ### is the qualified name, so tables of the same name in two schemas get their own tabs
+            std::string label = (relation ? relation->name : tab.name) + "###" + tab.name;
+            bool focus = dbState.focusActiveTab && tab.name == dbState.activeTab;
+            bool unsaved = tab.view->pendingChangeCount() > 0 || tab.view->isCommitting();
+            ImGuiTabItemFlags flags = (focus ? ImGuiTabItemFlags_SetSelected : 0) | (unsaved ? ImGuiTabItemFlags_UnsavedDocument : 0);
+            bool open = true;
+            if (ImGui::BeginTabItem(label.c_str(), &open, flags))
+            {
+                // A requested tab is shown from the next frame on; any other tab shown was picked in the tab bar
+                if (tab.name == dbState.activeTab)
+                {
+                    dbState.focusActiveTab = false;
+                }
+                else if (!dbState.focusActiveTab)
+                {
+                    dbState.activeTab = tab.name;
+                    dbState.selectedTable = tab.name;
+                }
+                renderTableTab(tab);
+                ImGui::EndTabItem();
+            }
+
+            // A tab with uncommitted edits stays open and comes forward, to be committed or discarded first
+            if (!open && unsaved)
+            {
+                open = true;
+                dbState.activeTab = tab.name;
+                dbState.selectedTable = tab.name;
+                dbState.focusActiveTab = true;
+            }
+            if (open)
+            {
+                i++;
+                continue;
+            }
+
+            // Closing drops the view and its jobs; ImGui shows a neighbour next frame, which then becomes active
+            if (tab.name == dbState.activeTab)
+            {
+                dbState.activeTab.clear();
+                dbState.selectedTable.clear();
+                dbState.focusActiveTab = false;
+            }
+            dbState.tabs.erase(dbState.tabs.begin() + i);
         }
-
-        dbState.tableView->render();
+        ImGui::EndTabBar();
     }
 
     ImGui::EndChild();
 }
 
-std::vector<std::string> DBE::fetchTables()
+void DBE::renderTableTab(TableTab &tab)
 {
-    std::vector<std::string> tables;
-    if (!dbState.conn)
-        return tables;
+    // A view whose rows were given back for the budget loads them again as soon as it is shown
+    tab.lastShown = ++dbState.tabClock;
+    tab.view->restoreRows();
+
+    ImGui::Dummy(ImVec2(0, 4.0f));
 
-    const char *query = "SELECT table_name FROM information_schema.tables WHERE table_schema = 'public'";
-    PGresult *res = PQexec(dbState.conn, query);
+    const SchemaCatalog::Relation *relation = dbState.catalog->find(tab.name);
+    std::string title = relation ? relation->name : tab.name;
+    if (!title.empty())
+    {
+        title[0] = std::toupper(title[0]);
+    }
+    title += " Table";
 
-    if (PQresultStatus(res) != PGRES_TUPLES_OK)
+    ImGui::Text("%s", title.c_str());
+    if (relation && relation->schema != "public")
     {
-        PQclear(res);
-        return tables;
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", relation->schema.c_str());
     }
+    ImGui::Separator();
+    ImGui::Dummy(ImVec2(0, 2.0f));
 
-    int rows = PQntuples(res);
-    for (int i = 0; i < rows; i++)
+    tab.view->render();
+}
+
+void DBE::openTable(const std::string &name)
+{
+    auto it = std::find_if(dbState.tabs.begin(), dbState.tabs.end(), [&name](const TableTab &tab) { return tab.name == name; });
+    if (it == dbState.tabs.end())
     {
-        tables.push_back(PQgetvalue(res, i, 0));
+        TableTab tab;
+        tab.name = name;
+        tab.view = std::make_unique<Table>(dbState.pool.get(), dbState.pageCache.get(), dbState.catalog.get());
+        tab.view->loadTableData(name, 0);
+        dbState.tabs.push_back(std::move(tab));
     }
+    dbState.activeTab = name;
+    dbState.focusActiveTab = true;
+}
 
-    PQclear(res);
-    return tables;
+size_t DBE::viewMemoryBytes() const
+{
+    size_t bytes = 0;
+    for (const auto &tab : dbState.tabs)
+    {
+        bytes += tab.view->memoryBytes();
+    }
+    return bytes;
+}
+
+void DBE::enforceViewBudget()
+{
+    size_t budget = static_cast<size_t>(dbState.viewBudgetMb) << 20;
+    size_t used = viewMemoryBytes();
+    if (used <= budget)
+        return;
+
+    // The tab on screen always keeps its rows; views that are loading or hold edits refuse to let go
+    std::vector<TableTab *> hidden;
+    for (auto &tab : dbState.tabs)
+    {
+        if (tab.name != dbState.activeTab && !tab.view->hasReleasedRows())
+        {
+            hidden.push_back(&tab);
+        }
+    }
+    std::sort(hidden.begin(), hidden.end(), [](const TableTab *a, const TableTab *b) { return a->lastShown < b->lastShown; });
+    for (TableTab *tab : hidden)
+    {
+        if (used <= budget)
+            break;
+        size_t bytes = tab->view->memoryBytes();
+        if (tab->view->releaseRows())
+        {
+            used -= std::min(bytes, used);
+        }
+    }
 }
 
 void DBE::connect()
 {
-    if (dbState.conn)
+    if (dbState.pool)
         return;
 
     auto startTime = std::chrono::high_resolution_clock::now();
 
-    dbState.conn = PQconnectdb(dbState.connStr);
-    if (PQstatus(dbState.conn) == CONNECTION_OK)
+    Trace::Scope trace("connect", "query");
+    PGconn *conn = PQconnectdb(dbState.connStr);
+    if (PQstatus(conn) == CONNECTION_OK)
     {
         auto endTime = std::chrono::high_resolution_clock::now();
         dbState.connectionTimeMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
 
-        dbState.connectedHost = PQhost(dbState.conn) ? PQhost(dbState.conn) : "localhost";
-        dbState.connectedUser = PQuser(dbState.conn) ? PQuser(dbState.conn) : "unknown";
-        dbState.connectedPort = PQport(dbState.conn) ? PQport(dbState.conn) : "5432";
+        dbState.connectedHost = PQhost(conn) ? PQhost(conn) : "localhost";
+        dbState.connectedUser = PQuser(conn) ? PQuser(conn) : "unknown";
+        dbState.connectedPort = PQport(conn) ? PQport(conn) : "5432";
+
+        // The verified connection becomes the pool's foreground one; the others connect in the background
+        dbState.pool = std::make_unique<ConnectionPool>(conn, dbState.connStr, dbState.poolSize);
+        dbState.pool->setStatementTimeout(dbState.statementTimeoutSec * 1000);
+        dbState.pageCache = std::make_unique<PageCache>(static_cast<size_t>(dbState.pageCacheMb) << 20);
+        dbState.catalog = std::make_unique<SchemaCatalog>(dbState.pool.get());
+
+        // The disk cache fills the catalog and page cache before anything is fetched and checks them in the background;
+        // a restored catalog only needs a refresh, which reloads just the relations that changed
+        dbState.diskCache = std::make_unique<DiskCache>(dbState.pool.get(), dbState.pageCache.get(), dbState.catalog.get(), conn);
+        bool restored = false;
+        if (dbState.useDiskCache)
+        {
+            restored = dbState.diskCache->restore();
+            dbState.diskCache->revalidate(
+                [this](const std::string &table)
+                {
+                    // A restored page already in a view that turned out stale is fetched again
+                    for (auto &tab : dbState.tabs)
+                    {
+                        const SchemaCatalog::Relation *relation = dbState.catalog->find(tab.name);
+                        if (relation && relation->quotedName == table)
+                        {
+                            tab.view->loadTableData(tab.name, 0);
+                        }
+                    }
+                });
+        }
 
-        dbState.tables = fetchTables();
-        dbState.tableView = std::make_unique<Table>(dbState.conn);
+        // Without a restored catalog the last table is opened only once the load lists it, so it is queried by its real name
+        if (restored)
+        {
+            dbState.selectedTable = dbState.diskCache->lastTable();
+            dbState.catalog->refresh();
+        }
+        else
+        {
+            dbState.pendingTable = dbState.useDiskCache ? dbState.diskCache->lastTable() : "";
+            dbState.catalog->load();
+        }
     }
     else
     {
-        std::cerr << "Connection failed: " << PQerrorMessage(dbState.conn) << std::endl;
-        PQfinish(dbState.conn);
-        dbState.conn = nullptr;
+        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
+        PQfinish(conn);
     }
 }
 
 void DBE::disconnect()
 {
-    if (!dbState.conn)
+    if (!dbState.pool)
         return;
 
-    dbState.tableView.reset();
-    PQfinish(dbState.conn);
-    dbState.conn = nullptr;
-    dbState.tables.clear();
+    // The disk cache is written while the catalog and pages it saves are still there
+    if (dbState.useDiskCache)
+    {
+        dbState.diskCache->save(dbState.activeTab);
+    }
+
+    // Views go first so they can discard their jobs; the pool joins its workers and closes the connections
+    dbState.tabs.clear();
+    dbState.diskCache.reset();
+    dbState.catalog.reset();
+    dbState.pool.reset();
+    dbState.pageCache.reset();
     dbState.selectedTable.clear();
+    dbState.pendingTable.clear();
+    dbState.activeTab.clear();
+    dbState.focusActiveTab = false;
+    dbState.collapsedSchemas.clear();
+    panelRows.clear();
+    panelDirty = true;
     dbState.connectedHost.clear();
     dbState.connectedUser.clear();
     dbState.connectedPort.clear();
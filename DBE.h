@@ -1,10 +1,17 @@
 // dbe.h
 #pragma once
 
+#include "ConnectionPool.h"
+#include "DiskCache.h"
+#include "PageCache.h"
+#include "QueryExecutor.h"
+#include "SchemaCatalog.h"
 #include "Table.h"
+#include "Trace.h"
 #include <imgui.h>
 #include <libpq-fe.h>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -17,27 +24,69 @@ class DBE
     // Main interface
     void render();   // Just renders the DBE content
     void shutdown(); // Just database cleanup
+    bool isWorking() const; // Some view is loading, streaming, exporting or importing
 
   private:
+    // Tabbed workspace: one view per opened table, keeping its rows, filters, sort and
+    // position while hidden, so switching back costs no query. All views share the pool
+    // and page cache; when their rows together exceed the view budget, the hidden views
+    // shown least recently give theirs back and reload them when shown again.
+    struct TableTab
+    {
+        std::string name; // Qualified name, schema.table
+        std::unique_ptr<Table> view;
+        uint64_t lastShown = 0;
+    };
+
     // Database connection state
     struct DatabaseState
     {
         char connStr[1024] = "";
         bool showPassword = false;
-        PGconn *conn = nullptr;
-        std::vector<std::string> tables;
-        std::string selectedTable;
-        std::unique_ptr<Table> tableView;
+        std::unique_ptr<ConnectionPool> pool;
+        int poolSize = 3;
+        int statementTimeoutSec = 30; // Per session on every pool connection, 0 for none
+        std::unique_ptr<PageCache> pageCache;
+        int pageCacheMb = 256;
+        std::unique_ptr<SchemaCatalog> catalog;
+        std::unique_ptr<DiskCache> diskCache;
+        bool useDiskCache = true;
+        char tableFilter[128] = "";
+        std::set<std::string> collapsedSchemas;
+        std::string selectedTable; // Qualified name, schema.table
+        std::string pendingTable;  // Last viewed table from the disk cache, opened once the catalog lists it
+        std::vector<TableTab> tabs;
+        std::string activeTab;
+        bool focusActiveTab = false; // Set when a tab is opened or picked in the left panel, until ImGui shows it
+        uint64_t tabClock = 0;
+        int viewBudgetMb = 512;
         std::string connectedHost;
         std::string connectedUser;
         std::string connectedPort;
         double connectionTimeMs = 0.0;
 
-        bool isConnected() const { return conn != nullptr; }
+        bool isConnected() const { return pool != nullptr; }
     } dbState;
 
+    // Left panel rows: schema headers and the relations of expanded schemas that pass
+    // the filter, rebuilt only when the catalog, the filter or an expansion changes
+    struct PanelRow
+    {
+        int schema;
+        int relation; // -1 for a schema header
+    };
+    std::vector<PanelRow> panelRows;
+    uint64_t panelVersion = 0;
+    bool panelDirty = true;
+    void rebuildPanelRows();
+
+    // Latency overlay, toggled with F12; percentiles are refreshed twice a second
+    bool showLatency = false;
+    std::vector<Trace::Summary> latencySummaries;
+    double latencyUpdated = -1.0;
+    std::string traceStatus;
+
     // Database operations
-    std::vector<std::string> fetchTables();
     void connect();
     void disconnect();
 
@@ -47,4 +96,11 @@ class DBE
     void renderContent();
     void renderLeftPanel();
     void renderMainPanel();
+    void renderTableTab(TableTab &tab);
+
+    // Workspace
+    void openTable(const std::string &name);
+    void enforceViewBudget();
+    size_t viewMemoryBytes() const;
+    void renderLatencyOverlay();
 };
\ No newline at end of file
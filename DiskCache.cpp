@@ -0,0 +1,297 @@
+#include "DiskCache.h"
+#include "BinaryIO.h"
+#include "Trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+constexpr std::string_view Magic = "DBECACHE";
+
+// FNV-1a, so a database maps to the same file name in every build
+uint64_t hashName(const std::string &text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : text)
+    {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string connectionValue(const char *value, const char *fallback) { return value && *value ? value : fallback; }
+} // namespace
+
+DiskCache::DiskCache(ConnectionPool *pool, PageCache *pageCache, SchemaCatalog *catalog, PGconn *conn) : pool(pool), pageCache(pageCache), catalog(catalog)
+{
+    // Server, database and user decide what the cached data is; the password and other options do not
+    identity = connectionValue(PQhost(conn), "localhost") + ":" + connectionValue(PQport(conn), "5432") + "/" + connectionValue(PQdb(conn), "") + " " + connectionValue(PQuser(conn), "");
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.cache", static_cast<unsigned long long>(hashName(identity)));
+    std::string dir = directory();
+    filePath = dir.empty() ? "" : dir + "/" + name;
+}
+
+DiskCache::~DiskCache() { pool->discard(this); }
+
+bool DiskCache::restore()
+{
+    Trace::Scope trace("restore", "cache", filePath);
+    restoredGeneration = pageCache->generation();
+
+    int fd = filePath.empty() ? -1 : open(filePath.c_str(), O_RDONLY);
+    struct stat info;
+    void *map = MAP_FAILED;
+    size_t size = 0;
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        size = static_cast<size_t>(info.st_size);
+        map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    bool catalogRestored = false;
+    if (map != MAP_FAILED)
+    {
+        // Every record is read right away, so the kernel may read the whole file ahead
+        posix_madvise(map, size, POSIX_MADV_WILLNEED);
+        BinaryReader reader(std::string_view(static_cast<const char *>(map), size));
+        std::string_view magic;
+        std::string_view savedIdentity;
+        uint32_t version = 0;
+        bool valid = reader.bytes(magic) && magic == Magic && reader.value(version) && version == FormatVersion && reader.bytes(savedIdentity) && savedIdentity == identity;
+
+        while (valid && !reader.atEnd())
+        {
+            uint8_t type = 0;
+            std::string_view payload;
+            if (!reader.value(type) || !reader.bytes(payload))
+                break;
+
+            BinaryReader record(payload);
+            switch (static_cast<Record>(type))
+            {
+            case Record::Catalog:
+                catalogRestored = catalog->restore(payload);
+                break;
+            case Record::Page:
+            {
+                std::string table;
+                std::string key;
+                std::string counters;
+                uint8_t moreRows = 0;
+                std::string_view image;
+                auto page = std::make_shared<ResultStore>();
+                if (record.bytes(table) && record.bytes(key) && record.bytes(counters) && record.value(moreRows) && record.bytes(image) && page->deserialize(image))
+                {
+                    pageCache->insert(table, key, {page, moreRows != 0}, restoredGeneration);
+                    if (pageCache->contains(key))
+                    {
+                        savedCounters[table] = counters;
+                        restoredCount++;
+                    }
+                }
+                break;
+            }
+            case Record::State:
+                record.bytes(restoredTable);
+                break;
+            default:
+                // Records from a newer build are skipped
+                break;
+            }
+        }
+        munmap(map, size);
+    }
+
+    // Pages fetched from here on are not saved until the counters they will be checked against are known
+    pageCache->barrier();
+    return catalogRestored;
+}
+
+void DiskCache::revalidate(Stale stale)
+{
+    revalidating = true;
+    QueryExecutor *executor = pool->foreground();
+    StatementCache *statements = &executor->statements();
+    executor->submit(this,
+                     [this, statements, stale](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         std::unordered_map<std::string, std::string> counters;
+                         bool ok = fetchCounters(conn, *statements, counters);
+                         return [this, counters, ok, stale]() { applyCounters(counters, ok, stale); };
+                     });
+}
+
+void DiskCache::applyCounters(const std::unordered_map<std::string, std::string> &counters, bool ok, const Stale &stale)
+{
+    revalidating = false;
+    staleCount = 0;
+    for (const auto &[table, saved] : savedCounters)
+    {
+        // Without fresh counters nothing restored can be trusted
+        auto current = counters.find(table);
+        if (ok && current != counters.end() && current->second == saved)
+            continue;
+
+        pageCache->invalidate(table);
+        staleCount++;
+        if (stale)
+        {
+            stale(table);
+        }
+    }
+    savedCounters.clear();
+    if (!ok)
+        return;
+
+    // Pages fetched while the counters were being read may predate them; only later ones are saved with them
+    currentCounters = counters;
+    verified = true;
+    verifiedGeneration = pageCache->barrier();
+}
+
+bool DiskCache::fetchCounters(PGconn *conn, StatementCache &statements, std::unordered_map<std::string, std::string> &counters)
+{
+    // Inserts, updates and deletes only ever grow; live tuples also catch a TRUNCATE
+    SqlQuery query;
+    query.sql = "SELECT schemaname, relname, concat_ws(':', n_tup_ins, n_tup_upd, n_tup_del, n_live_tup) FROM pg_stat_user_tables";
+    PGresult *result = statements.execute(conn, query);
+    if (PQresultStatus(result) != PGRES_TUPLES_OK)
+    {
+        std::cerr << "Cache revalidation failed: " << PQerrorMessage(conn) << std::endl;
+        PQclear(result);
+        return false;
+    }
+
+    int count = PQntuples(result);
+    counters.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        std::string table = SchemaCatalog::quoteIdentifier(PQgetvalue(result, i, 0)) + "." + SchemaCatalog::quoteIdentifier(PQgetvalue(result, i, 1));
+        counters[table] = PQgetvalue(result, i, 2);
+    }
+    PQclear(result);
+    return true;
+}
+
+bool DiskCache::save(const std::string &lastTable)
+{
+    if (filePath.empty())
+        return false;
+
+    Trace::Scope trace("save", "cache", filePath);
+    std::error_code error;
+    std::filesystem::create_directories(directory(), error);
+    std::string partial = filePath + ".part";
+    FILE *file = std::fopen(partial.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Could not write disk cache " << partial << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    bool ok = true;
+    std::string header;
+    auto write = [&](std::string_view bytes) { ok = ok && std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size(); };
+    auto writeRecord = [&](Record type, const std::string &payload)
+    {
+        header.clear();
+        BinaryWriter writer(header);
+        writer.value<uint8_t>(static_cast<uint8_t>(type));
+        writer.value<uint64_t>(payload.size());
+        write(header);
+        write(payload);
+    };
+
+    BinaryWriter writer(header);
+    writer.bytes(Magic);
+    writer.value<uint32_t>(FormatVersion);
+    writer.bytes(identity);
+    write(header);
+
+    std::string payload = catalog->serialize();
+    if (!payload.empty())
+    {
+        writeRecord(Record::Catalog, payload);
+    }
+
+    payload.clear();
+    BinaryWriter(payload).bytes(lastTable);
+    writeRecord(Record::State, payload);
+
+    // Most recently used pages first, up to the budget, and only those the saved counters vouch for
+    size_t savedBytes = 0;
+    if (verified)
+    {
+        std::string image;
+        pageCache->visit(
+            [&](const std::string &table, const std::string &key, const PageCache::Entry &entry, uint64_t generation)
+            {
+                auto counters = currentCounters.find(table);
+                bool vouched = generation == restoredGeneration || generation >= verifiedGeneration;
+                if (!vouched || counters == currentCounters.end() || savedBytes >= MaxSavedBytes)
+                    return;
+
+                image.clear();
+                entry.page->serialize(image);
+                payload.clear();
+                BinaryWriter page(payload);
+                page.bytes(table);
+                page.bytes(key);
+                page.bytes(counters->second);
+                page.value<uint8_t>(entry.moreRows);
+                page.bytes(image);
+                writeRecord(Record::Page, payload);
+                savedBytes += payload.size();
+            });
+    }
+
+    ok = std::fclose(file) == 0 && ok;
+    if (ok && std::rename(partial.c_str(), filePath.c_str()) != 0)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        std::cerr << "Could not write disk cache " << filePath << ": " << std::strerror(errno) << std::endl;
+        std::remove(partial.c_str());
+        return false;
+    }
+    return true;
+}
+
+void DiskCache::erase()
+{
+    if (!filePath.empty())
+    {
+        std::remove(filePath.c_str());
+    }
+}
+
+std::string DiskCache::directory()
+{
+    if (const char *cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+        return std::string(cache) + "/db_explorer";
+
+    const char *home = std::getenv("HOME");
+    if (!home || !*home)
+        return "";
+#ifdef __APPLE__
+    return std::string(home) + "/Library/Caches/db_explorer";
+#else
+    return std::string(home) + "/.cache/db_explorer";
+#endif
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+// Standard library includes
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "ConnectionPool.h"
+#include "PageCache.h"
+#include "SchemaCatalog.h"
+
+// Keeps the catalog and the recently viewed pages of one database in a file in
+// the user's cache directory, so reconnecting shows the table list and the last
+// page before any query returns. The file is named after the server, database
+// and user, never the password, and holds a flat sequence of records: the
+// catalog snapshot, pages as columnar ResultStore images keyed by table and
+// query shape, and the last viewed table. It is mapped read-only on restore and
+// replaced atomically on save.
+//
+// Restored pages are shown at once and revalidated in the background. Each page
+// is saved with its table's modification counters from pg_stat_user_tables, and
+// tables whose counters moved since are dropped from the page cache when the
+// fresh counters arrive. The catalog revalidates itself through its signature
+// refresh. Tables without statistics, such as views, are never saved. The server
+// updates the counters shortly after a commit, so a change made moments before
+// connecting may only show once its table is reloaded.
+class DiskCache
+{
+  public:
+    // Constructor/Destructor
+    DiskCache(ConnectionPool *pool, PageCache *pageCache, SchemaCatalog *catalog, PGconn *conn);
+    ~DiskCache();
+
+    using Stale = std::function<void(const std::string &table)>;
+
+    // Main public interface; restore() runs before anything is fetched and returns whether the
+    // catalog came from the file, revalidate() reports each restored table that changed since
+    bool restore();
+    void revalidate(Stale stale);
+    bool save(const std::string &lastTable);
+    void erase();
+    const std::string &lastTable() const { return restoredTable; }
+
+    // Status
+    const std::string &path() const { return filePath; }
+    bool isRevalidating() const { return revalidating; }
+    int restoredPages() const { return restoredCount; }
+    int staleTables() const { return staleCount; }
+
+  private:
+    static constexpr uint32_t FormatVersion = 1;
+    static constexpr size_t MaxSavedBytes = 64u << 20;
+
+    enum class Record : uint8_t
+    {
+        Catalog,
+        Page,
+        State,
+    };
+
+    ConnectionPool *pool;
+    PageCache *pageCache;
+    SchemaCatalog *catalog;
+    std::string identity;
+    std::string filePath;
+    std::string restoredTable;
+
+    // Counters per quoted table name: as saved with the restored pages, and as read from the server this session
+    std::unordered_map<std::string, std::string> savedCounters;
+    std::unordered_map<std::string, std::string> currentCounters;
+    bool revalidating = false;
+    bool verified = false;
+    int restoredCount = 0;
+    int staleCount = 0;
+
+    // Restored pages keep the generation they were inserted in; pages fetched from verifiedGeneration on postdate the counters
+    uint64_t restoredGeneration = 0;
+    uint64_t verifiedGeneration = 0;
+
+    void applyCounters(const std::unordered_map<std::string, std::string> &counters, bool ok, const Stale &stale);
+    static bool fetchCounters(PGconn *conn, StatementCache &statements, std::unordered_map<std::string, std::string> &counters);
+    static std::string directory();
+};
@@ -0,0 +1,333 @@
+#include "Exporter.h"
+#include "Trace.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+
+namespace
+{
+// The file is written through one buffer this size, so each row costs a memcpy rather than a syscall
+constexpr size_t WriteBufferSize = 1 << 20;
+} // namespace
+
+Exporter::Exporter(ConnectionPool *pool) : pool(pool) {}
+
+Exporter::~Exporter()
+{
+    // A running COPY is cancelled; its job only touches the shared progress, never the exporter
+    cancel();
+    if (pool)
+    {
+        pool->discard(this);
+    }
+}
+
+bool Exporter::start(const SqlQuery &source, const std::vector<std::string> &columns, const std::string &path, Format format, long long estimate)
+{
+    if (running || !pool || path.empty())
+        return false;
+
+    auto state = std::make_shared<Progress>();
+    state->startNs = Trace::now();
+    progress = state;
+    running = true;
+    expected = estimate;
+    outputPath = path;
+    statusText = "Exporting to " + path;
+
+    // COPY text has no header line on older servers, so the TSV header is written here; CSV asks the server for one
+    std::string header = format == Format::Tsv ? textHeader(columns) : "";
+    QueryExecutor *background = pool->background();
+
+    background->submit(this,
+                       [this, state, source, format, header, path](PGconn *conn) -> QueryExecutor::Completion
+                       {
+                           std::string error;
+                           std::string inlined = inlineParameters(conn, source);
+                           bool success = false;
+                           if (inlined.empty())
+                           {
+                               error = "Could not quote the export's parameters";
+                           }
+                           else
+                           {
+                               success = copyToFile(conn, copyStatement(inlined, format), header, path, *state, error);
+                           }
+                           state->endNs = Trace::now();
+                           return [this, state, success, error, path]()
+                           {
+                               if (state != progress)
+                                   return;
+
+                               running = false;
+                               if (success)
+                               {
+                                   statusText = "Exported " + std::to_string(state->rows.load()) + " rows to " + path;
+                               }
+                               else
+                               {
+                                   statusText = state->stop ? "Export cancelled" : "Export failed: " + error;
+                               }
+                           };
+                       });
+    return true;
+}
+
+void Exporter::cancel()
+{
+    if (progress)
+    {
+        progress->stop = true;
+    }
+}
+
+long long Exporter::rowsWritten() const { return progress ? progress->rows.load() : 0; }
+
+uint64_t Exporter::bytesWritten() const { return progress ? progress->bytes.load() : 0; }
+
+double Exporter::elapsedSeconds() const
+{
+    if (!progress)
+        return 0;
+    uint64_t end = running ? Trace::now() : progress->endNs;
+    return (end - progress->startNs) / 1e9;
+}
+
+const char *Exporter::extension(Format format)
+{
+    switch (format)
+    {
+    case Format::Csv:
+        return ".csv";
+    case Format::Tsv:
+        return ".tsv";
+    case Format::Binary:
+        return ".pgcopy";
+    }
+    return "";
+}
+
+std::string Exporter::inlineParameters(PGconn *conn, const SqlQuery &query)
+{
+    // Placeholders are replaced outside quoted identifiers and literals. Inlined
+    // values are untyped literals, which the server resolves from their context
+    // just as it infers the type of a parameter.
+    std::string sql;
+    sql.reserve(query.sql.size());
+    char quote = 0;
+    for (size_t i = 0; i < query.sql.size(); i++)
+    {
+        char c = query.sql[i];
+        if (quote)
+        {
+            quote = c == quote ? 0 : quote;
+            sql += c;
+            continue;
+        }
+        if (c == '\'' || c == '"')
+        {
+            quote = c;
+            sql += c;
+            continue;
+        }
+        if (c != '$' || i + 1 >= query.sql.size() || !std::isdigit(static_cast<unsigned char>(query.sql[i + 1])))
+        {
+            sql += c;
+            continue;
+        }
+
+        size_t end = i + 1;
+        while (end < query.sql.size() && std::isdigit(static_cast<unsigned char>(query.sql[end])))
+        {
+            end++;
+        }
+        size_t index = std::strtoul(query.sql.c_str() + i + 1, nullptr, 10);
+        if (index == 0 || index > query.params.size())
+            return "";
+
+        const std::string &value = query.params[index - 1];
+        char *literal = PQescapeLiteral(conn, value.c_str(), value.size());
+        if (!literal)
+        {
+            std::cerr << "Could not quote export parameter: " << PQerrorMessage(conn) << std::endl;
+            return "";
+        }
+        sql += literal;
+        PQfreemem(literal);
+        i = end - 1;
+    }
+    return sql;
+}
+
+std::string Exporter::copyStatement(const std::string &source, Format format)
+{
+    switch (format)
+    {
+    case Format::Csv:
+        return "COPY " + source + " TO STDOUT WITH (FORMAT csv, HEADER)";
+    case Format::Tsv:
+        return "COPY " + source + " TO STDOUT WITH (FORMAT text)";
+    case Format::Binary:
+        return "COPY " + source + " TO STDOUT WITH (FORMAT binary)";
+    }
+    return "";
+}
+
+std::string Exporter::textHeader(const std::vector<std::string> &columns)
+{
+    // Names are escaped the way COPY text escapes values, so the header parses like any row
+    std::string header;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        header += i > 0 ? "\t" : "";
+        for (char c : columns[i])
+        {
+            switch (c)
+            {
+            case '\\':
+                header += "\\\\";
+                break;
+            case '\t':
+                header += "\\t";
+                break;
+            case '\n':
+                header += "\\n";
+                break;
+            case '\r':
+                header += "\\r";
+                break;
+            default:
+                header += c;
+            }
+        }
+    }
+    return header + "\n";
+}
+
+bool Exporter::copyToFile(PGconn *conn, const std::string &statement, const std::string &header, const std::string &path, Progress &progress, std::string &error)
+{
+    Trace::Scope trace("export", "query", path);
+
+    std::string partial = path + ".part";
+    FILE *file = std::fopen(partial.c_str(), "wb");
+    if (!file)
+    {
+        error = "could not open " + partial + ": " + std::strerror(errno);
+        return false;
+    }
+    std::vector<char> buffer(WriteBufferSize);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    bool writeFailed = !header.empty() && std::fwrite(header.data(), 1, header.size(), file) != header.size();
+    if (writeFailed)
+    {
+        error = std::string("write to ") + partial + " failed: " + std::strerror(errno);
+    }
+    progress.bytes += header.size();
+
+    // Waiting in poll with a timeout keeps a pending cancel noticed even while the server is still sorting
+    bool cancelled = false;
+    auto waitForInput = [&]()
+    {
+        if (!cancelled && (progress.stop || writeFailed))
+        {
+            QueryExecutor::cancelQuery(conn);
+            cancelled = true;
+        }
+        pollfd socket = {PQsocket(conn), POLLIN, 0};
+        poll(&socket, 1, 100);
+        return PQconsumeInput(conn) != 0;
+    };
+
+    // An export takes as long as the data does; the session's statement_timeout is lifted for this transaction only
+    if (!writeFailed)
+    {
+        PQclear(PQexec(conn, "BEGIN; SET LOCAL statement_timeout = 0"));
+    }
+
+    bool connectionOk = !writeFailed && PQsendQuery(conn, statement.c_str());
+    while (connectionOk && PQisBusy(conn))
+    {
+        connectionOk = waitForInput();
+    }
+
+    PGresult *result = connectionOk ? PQgetResult(conn) : nullptr;
+    bool copying = PQresultStatus(result) == PGRES_COPY_OUT;
+    if (!copying && connectionOk)
+    {
+        error = PQresultErrorMessage(result);
+    }
+    PQclear(result);
+
+    // One row per CopyData message; libpq hands each over in its own allocation
+    while (copying)
+    {
+        char *row = nullptr;
+        int length = PQgetCopyData(conn, &row, 1);
+        if (length > 0)
+        {
+            if (!writeFailed && std::fwrite(row, 1, length, file) != static_cast<size_t>(length))
+            {
+                writeFailed = true;
+                error = std::string("write to ") + partial + " failed: " + std::strerror(errno);
+            }
+            PQfreemem(row);
+            progress.rows.fetch_add(1, std::memory_order_relaxed);
+            progress.bytes.fetch_add(length, std::memory_order_relaxed);
+        }
+        else if (length == 0)
+        {
+            copying = waitForInput();
+        }
+        else
+        {
+            if (length == -2 && error.empty())
+            {
+                error = PQerrorMessage(conn);
+            }
+            break;
+        }
+    }
+
+    // The COPY's own result carries the row count, or the server's error after a cancel
+    bool completed = false;
+    while (connectionOk && (result = PQgetResult(conn)))
+    {
+        if (PQresultStatus(result) == PGRES_COMMAND_OK)
+        {
+            progress.rows = std::atoll(PQcmdTuples(result));
+            completed = true;
+        }
+        else if (error.empty())
+        {
+            error = PQresultErrorMessage(result);
+        }
+        PQclear(result);
+    }
+    if (!connectionOk && error.empty())
+    {
+        error = PQerrorMessage(conn);
+    }
+    if (PQtransactionStatus(conn) != PQTRANS_IDLE)
+    {
+        PQclear(PQexec(conn, "ROLLBACK"));
+    }
+
+    bool closed = std::fclose(file) == 0;
+    bool success = completed && !writeFailed && !cancelled && closed;
+    if (success && std::rename(partial.c_str(), path.c_str()) != 0)
+    {
+        error = "could not rename " + partial + ": " + std::strerror(errno);
+        success = false;
+    }
+    if (!success)
+    {
+        std::remove(partial.c_str());
+        std::cerr << "Export failed: " << error << std::endl;
+    }
+    return success;
+}
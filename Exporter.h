@@ -0,0 +1,77 @@
+#pragma once
+
+// Standard library includes
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "ConnectionPool.h"
+#include "QueryExecutor.h"
+
+// Writes a relation or a query to a file with COPY ... TO STDOUT, read through
+// PQgetCopyData on one of the pool's background connections. Each row is written
+// to the file as it arrives, so memory use stays at one row plus libpq's and the
+// file's buffers no matter how large the result is. The file is written under a
+// temporary name and renamed when the copy completes; a cancelled or failed
+// export removes it.
+//
+// COPY takes no parameters, so the query's bound values are inlined as escaped
+// literals on the worker before the statement is sent.
+class Exporter
+{
+  public:
+    enum class Format
+    {
+        Csv,    // RFC 4180 with a header line
+        Tsv,    // COPY text format: tab separated, backslash escapes, \N for NULL
+        Binary, // COPY binary format, readable by COPY FROM (FORMAT binary)
+    };
+
+    // Constructor/Destructor
+    explicit Exporter(ConnectionPool *pool);
+    ~Exporter();
+
+    // Main public interface; source is a quoted relation name or a parenthesized query
+    bool start(const SqlQuery &source, const std::vector<std::string> &columns, const std::string &path, Format format, long long estimate = -1);
+    void cancel();
+    bool isRunning() const { return running; }
+
+    // Progress, readable from the UI thread while the export runs
+    long long rowsWritten() const;
+    uint64_t bytesWritten() const;
+    long long expectedRows() const { return expected; }
+    double elapsedSeconds() const;
+    const std::string &status() const { return statusText; }
+    const std::string &path() const { return outputPath; }
+
+    static const char *extension(Format format);
+    static std::string inlineParameters(PGconn *conn, const SqlQuery &query);
+
+  private:
+    // Shared with the running job, which may outlive the exporter by one cancelled COPY
+    struct Progress
+    {
+        std::atomic<long long> rows{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<bool> stop{false};
+        uint64_t startNs = 0;
+        uint64_t endNs = 0;
+    };
+
+    ConnectionPool *pool;
+    std::shared_ptr<Progress> progress;
+    bool running = false;
+    long long expected = -1;
+    std::string statusText;
+    std::string outputPath;
+
+    static std::string copyStatement(const std::string &source, Format format);
+    static std::string textHeader(const std::vector<std::string> &columns);
+    static bool copyToFile(PGconn *conn, const std::string &statement, const std::string &header, const std::string &path, Progress &progress, std::string &error);
+};
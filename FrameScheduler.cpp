@@ -0,0 +1,94 @@
+#include "FrameScheduler.h"
+#include <atomic>
+#include <imgui.h>
+
+namespace
+{
+std::atomic<bool> inputSeen{true};
+std::atomic<bool> woken{false};
+
+// Every callback only notes that input arrived; ImGui's own callbacks run after these
+void noteActivity() { inputSeen = true; }
+void onWindowFocus(GLFWwindow *, int) { noteActivity(); }
+void onCursorEnter(GLFWwindow *, int) { noteActivity(); }
+void onCursorPos(GLFWwindow *, double, double) { noteActivity(); }
+void onMouseButton(GLFWwindow *, int, int, int) { noteActivity(); }
+void onScroll(GLFWwindow *, double, double) { noteActivity(); }
+void onKey(GLFWwindow *, int, int, int, int) { noteActivity(); }
+void onChar(GLFWwindow *, unsigned int) { noteActivity(); }
+void onWindowSize(GLFWwindow *, int, int) { noteActivity(); }
+void onWindowRefresh(GLFWwindow *) { noteActivity(); }
+} // namespace
+
+FrameScheduler::FrameScheduler(GLFWwindow *window)
+{
+    glfwSetWindowFocusCallback(window, onWindowFocus);
+    glfwSetCursorEnterCallback(window, onCursorEnter);
+    glfwSetCursorPosCallback(window, onCursorPos);
+    glfwSetMouseButtonCallback(window, onMouseButton);
+    glfwSetScrollCallback(window, onScroll);
+    glfwSetKeyCallback(window, onKey);
+    glfwSetCharCallback(window, onChar);
+    glfwSetWindowSizeCallback(window, onWindowSize);
+    glfwSetWindowRefreshCallback(window, onWindowRefresh);
+}
+
+void FrameScheduler::waitForFrame()
+{
+    if (pendingFrames > 0)
+    {
+        pendingFrames--;
+        glfwPollEvents();
+    }
+    else
+    {
+        glfwWaitEventsTimeout(timeout());
+    }
+
+    // Input and finished background work both restart the settle frames
+    double now = glfwGetTime();
+    bool input = inputSeen.exchange(false);
+    if (input)
+    {
+        lastActivity = now;
+    }
+    if (woken.exchange(false) || input)
+    {
+        pendingFrames = SettleFrames;
+    }
+    updateRate(now);
+}
+
+void FrameScheduler::wake()
+{
+    // Safe from any thread; the empty event ends glfwWaitEventsTimeout on the main thread
+    woken = true;
+    glfwPostEmptyEvent();
+}
+
+double FrameScheduler::timeout() const
+{
+    // Reads the previous frame's state, which is what is on screen while waiting
+    if (busy)
+        return BusyTimeout;
+    if (glfwGetTime() - lastActivity > AnimationWindow)
+        return IdleTimeout;
+
+    const ImGuiIO &io = ImGui::GetIO();
+    if (ImGui::IsAnyItemHovered() || ImGui::IsAnyItemActive())
+        return HoverTimeout;
+    if (io.WantTextInput)
+        return CaretTimeout;
+    return IdleTimeout;
+}
+
+void FrameScheduler::updateRate(double now)
+{
+    fpsFrames++;
+    if (now - fpsWindowStart >= 1.0)
+    {
+        fps = fpsFrames / (now - fpsWindowStart);
+        fpsFrames = 0;
+        fpsWindowStart = now;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// External library includes
+#include <GLFW/glfw3.h>
+
+// Decides when the main loop draws the next frame. While nothing happens the loop
+// sleeps in glfwWaitEventsTimeout; input events and wake() (called from query
+// workers when they hand back a result) end the wait at once. Each wake-up is
+// followed by a few extra frames so layout changes and ImGui's own animations
+// settle, and for a short while after input the loop keeps a low frame rate for
+// hover tooltips and the text caret. While the application reports work that
+// changes the screen without handing back a result (export and import progress,
+// a stream, a load that may be dropped) it draws at BusyTimeout. Otherwise it
+// draws once per IdleTimeout so timed work (health checks) still runs.
+//
+// Must be constructed before ImGui_ImplGlfw_InitForOpenGL so ImGui chains the
+// input callbacks it installs.
+class FrameScheduler
+{
+  public:
+    // Constructor
+    explicit FrameScheduler(GLFWwindow *window);
+
+    // Main public interface
+    void waitForFrame();
+    void setBusy(bool working) { busy = working; }
+    static void wake();
+
+    // Statistics
+    double framesPerSecond() const { return fps; }
+
+  private:
+    static constexpr int SettleFrames = 3;
+    static constexpr double IdleTimeout = 1.0;     // Seconds between frames when nothing happens
+    static constexpr double HoverTimeout = 0.1;    // Lets hover tooltips appear after their delay
+    static constexpr double CaretTimeout = 0.25;   // Keeps the text caret blinking
+    static constexpr double BusyTimeout = 0.1;     // Keeps progress moving while background work runs
+    static constexpr double AnimationWindow = 5.0; // Seconds after input that hover and caret frames continue
+
+    int pendingFrames = SettleFrames;
+    bool busy = false;
+    double lastActivity = 0;
+    double fps = 0;
+    double fpsWindowStart = 0;
+    int fpsFrames = 0;
+
+    double timeout() const;
+    void updateRate(double now);
+};
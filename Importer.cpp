@@ -0,0 +1,507 @@
+#include "Importer.h"
+#include "SchemaCatalog.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+// The file is read, and sent, in blocks this size; a record longer than a block grows the buffer
+constexpr size_t ReadBlockSize = 1 << 20;
+
+// One record: where it ends (just past its newline) and how many fields it has
+struct Record
+{
+    size_t end = 0;
+    int fields = 1;
+    int lines = 0;
+    bool complete = false;
+    bool blank = false;
+};
+
+Record scanRecord(const char *data, size_t begin, size_t size, Importer::Format format)
+{
+    Record record;
+    if (format == Importer::Format::Csv)
+    {
+        // Doubled quotes inside a quoted field toggle twice, so only the quoting state matters here
+        bool quoted = false;
+        for (size_t i = begin; i < size; i++)
+        {
+            char c = data[i];
+            if (c == '"')
+            {
+                quoted = !quoted;
+            }
+            else if (c == ',' && !quoted)
+            {
+                record.fields++;
+            }
+            else if (c == '\n')
+            {
+                record.lines++;
+                if (!quoted)
+                {
+                    record.end = i + 1;
+                    record.complete = true;
+                    break;
+                }
+            }
+        }
+    }
+    else
+    {
+        // A backslash escapes the next byte, an escaped newline included
+        bool escaped = false;
+        for (size_t i = begin; i < size; i++)
+        {
+            char c = data[i];
+            if (escaped)
+            {
+                escaped = false;
+                record.lines += c == '\n';
+            }
+            else if (c == '\\')
+            {
+                escaped = true;
+            }
+            else if (c == '\t')
+            {
+                record.fields++;
+            }
+            else if (c == '\n')
+            {
+                record.lines++;
+                record.end = i + 1;
+                record.complete = true;
+                break;
+            }
+        }
+    }
+
+    if (!record.complete)
+    {
+        record.end = size;
+    }
+    size_t length = record.end - begin;
+    record.blank = length == 0 || (length <= 2 && std::all_of(data + begin, data + record.end, [](char c) { return c == '\r' || c == '\n'; }));
+    return record;
+}
+
+// The number after "line " in a COPY error context or notice, or 0
+long long copyLine(const char *text)
+{
+    const char *line = text ? std::strstr(text, "line ") : nullptr;
+    return line ? std::atoll(line + 5) : 0;
+}
+} // namespace
+
+Importer::Importer(ConnectionPool *pool) : pool(pool) {}
+
+Importer::~Importer()
+{
+    // A running import is rolled back; its job only touches the shared progress, never the importer
+    cancel();
+    if (pool)
+    {
+        pool->discard(this);
+    }
+}
+
+bool Importer::start(const std::string &relation, const std::vector<std::string> &columns, const std::string &path, const Options &options, Finished finished)
+{
+    if (running || !pool || path.empty())
+        return false;
+
+    auto state = std::make_shared<Progress>();
+    state->startNs = Trace::now();
+    progress = state;
+    running = true;
+    statusText = "Importing " + path;
+    QueryExecutor *background = pool->background();
+
+    background->submit(this,
+                       [this, state, relation, columns, path, options, finished](PGconn *conn) -> QueryExecutor::Completion
+                       {
+                           std::string error;
+                           bool committed = copyFromFile(conn, relation, columns, path, options, *state, error);
+                           state->endNs = Trace::now();
+                           return [this, state, committed, error, finished]()
+                           {
+                               if (state != progress)
+                                   return;
+
+                               running = false;
+                               char summary[160];
+                               if (committed)
+                               {
+                                   snprintf(summary, sizeof(summary), "Imported %lld rows in %.1f s (%.0f rows/s), %lld skipped", state->rows.load(), elapsedSeconds(), rowsPerSecond(), state->skipped.load());
+                                   statusText = summary;
+                               }
+                               else
+                               {
+                                   statusText = state->stop ? "Import cancelled, rolled back" : "Import failed, rolled back: " + error;
+                               }
+                               if (finished)
+                               {
+                                   finished(committed);
+                               }
+                           };
+                       });
+    return true;
+}
+
+void Importer::cancel()
+{
+    if (progress)
+    {
+        progress->stop = true;
+    }
+}
+
+long long Importer::rowsSent() const { return progress ? progress->rows.load() : 0; }
+
+long long Importer::rowsSkipped() const { return progress ? progress->skipped.load() : 0; }
+
+uint64_t Importer::bytesRead() const { return progress ? progress->bytes.load() : 0; }
+
+uint64_t Importer::fileBytes() const { return progress ? progress->fileSize.load() : 0; }
+
+double Importer::elapsedSeconds() const
+{
+    if (!progress)
+        return 0;
+    uint64_t end = running ? Trace::now() : progress->endNs.load();
+    return (end - progress->startNs) / 1e9;
+}
+
+double Importer::rowsPerSecond() const
+{
+    double seconds = elapsedSeconds();
+    return seconds > 0 ? rowsSent() / seconds : 0;
+}
+
+std::vector<Importer::RowError> Importer::rowErrors() const
+{
+    if (!progress)
+        return {};
+    std::lock_guard<std::mutex> lock(progress->errorsMutex);
+    return progress->errors;
+}
+
+Importer::Format Importer::formatForPath(const std::string &path)
+{
+    std::string extension = path.substr(std::min(path.size(), path.rfind('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+    return extension == ".tsv" || extension == ".tab" || extension == ".txt" ? Format::Tsv : Format::Csv;
+}
+
+void Importer::Progress::report(long long row, const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(errorsMutex);
+    if (errors.size() < MaxReportedErrors)
+    {
+        errors.push_back({row, message});
+    }
+}
+
+long long Importer::Progress::fileRow(long long sentRow) const
+{
+    // Every row left out on the client before the answer shifts it by one
+    long long row = sentRow;
+    for (long long skippedRow : skippedRows)
+    {
+        if (skippedRow > row)
+            break;
+        row++;
+    }
+    return row;
+}
+
+void Importer::onNotice(void *arg, const PGresult *result)
+{
+    // ON_ERROR ignore with LOG_VERBOSITY verbose reports each skipped row as a notice
+    Progress &progress = *static_cast<Progress *>(arg);
+    const char *message = PQresultErrorField(result, PG_DIAG_MESSAGE_PRIMARY);
+    if (!message || std::strncmp(message, "skipping row", 12) != 0)
+        return;
+
+    long long row = progress.fileRow(copyLine(message));
+    const char *column = std::strstr(message, "for column ");
+    progress.report(row, column ? column + 4 : message);
+    progress.skipped++;
+}
+
+std::vector<std::string> Importer::parseHeader(const char *begin, const char *end, Format format)
+{
+    std::vector<std::string> names(1);
+    bool quoted = false;
+    for (const char *c = begin; c < end; c++)
+    {
+        if (*c == '\r' || (*c == '\n' && !quoted))
+            continue;
+        if (format == Format::Csv && *c == '"')
+        {
+            // A doubled quote inside quotes is a literal quote
+            if (quoted && c + 1 < end && c[1] == '"')
+            {
+                names.back() += '"';
+                c++;
+            }
+            else
+            {
+                quoted = !quoted;
+            }
+        }
+        else if (format == Format::Tsv && *c == '\\' && c + 1 < end)
+        {
+            c++;
+            names.back() += *c == 't' ? '\t' : *c == 'n' ? '\n' : *c;
+        }
+        else if (*c == (format == Format::Csv ? ',' : '\t') && !quoted)
+        {
+            names.emplace_back();
+        }
+        else
+        {
+            names.back() += *c;
+        }
+    }
+    return names;
+}
+
+bool Importer::copyFromFile(PGconn *conn, const std::string &relation, const std::vector<std::string> &columns, const std::string &path, const Options &options, Progress &progress, std::string &error)
+{
+    Trace::Scope trace("import", "query", path);
+
+    FILE *file = std::fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        error = "could not open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    if (std::fseek(file, 0, SEEK_END) == 0)
+    {
+        progress.fileSize = std::max(0L, std::ftell(file));
+        std::fseek(file, 0, SEEK_SET);
+    }
+
+    // Like an export, an import is not cut short by the session's statement_timeout
+    PQclear(PQexec(conn, "BEGIN; SET LOCAL statement_timeout = 0"));
+    PQnoticeReceiver previousReceiver = PQsetNoticeReceiver(conn, onNotice, &progress);
+
+    std::vector<char> buffer(ReadBlockSize);
+    size_t filled = 0;
+    bool endOfFile = false;
+    bool headerPending = options.header;
+    bool copying = false;
+    bool failed = false;
+    int expectedFields = static_cast<int>(columns.size());
+    long long fileRow = 0;
+    long long fileLine = 1;
+
+    // Starts the COPY once the column list is known, i.e. after the header row if there is one
+    auto beginCopy = [&](const std::vector<std::string> &names)
+    {
+        std::string list;
+        for (const auto &name : names)
+        {
+            list += (list.empty() ? "" : ", ") + SchemaCatalog::quoteIdentifier(name);
+        }
+        std::string sql = "COPY " + relation + " (" + list + ") FROM STDIN WITH (FORMAT " + (options.format == Format::Csv ? "csv" : "text");
+        if (options.skipBadRows && PQserverVersion(conn) >= 170000)
+        {
+            sql += ", ON_ERROR ignore, LOG_VERBOSITY verbose";
+        }
+        sql += ")";
+
+        PGresult *result = PQexec(conn, sql.c_str());
+        copying = PQresultStatus(result) == PGRES_COPY_IN;
+        if (!copying)
+        {
+            error = PQresultErrorMessage(result);
+        }
+        PQclear(result);
+        expectedFields = static_cast<int>(names.size());
+        return copying;
+    };
+
+    auto send = [&](size_t begin, size_t end)
+    {
+        if (end > begin && PQputCopyData(conn, buffer.data() + begin, static_cast<int>(end - begin)) != 1)
+        {
+            error = PQerrorMessage(conn);
+            failed = true;
+        }
+    };
+
+    if (!options.header && !beginCopy(columns))
+    {
+        failed = true;
+    }
+
+    while (!failed && !progress.stop)
+    {
+        if (!endOfFile)
+        {
+            if (filled == buffer.size())
+            {
+                buffer.resize(buffer.size() * 2);
+            }
+            size_t count = std::fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+            filled += count;
+            progress.bytes += count;
+            endOfFile = count == 0;
+            if (endOfFile && std::ferror(file))
+            {
+                error = "read from " + path + " failed: " + std::strerror(errno);
+                failed = true;
+                break;
+            }
+        }
+
+        // Well-formed records between runStart and recordStart are sent as one slice of the buffer
+        size_t recordStart = 0;
+        size_t runStart = 0;
+        while (!failed && recordStart < filled)
+        {
+            Record record = scanRecord(buffer.data(), recordStart, filled, options.format);
+            if (!record.complete && !endOfFile)
+                break;
+
+            long long line = fileLine;
+            fileLine += record.lines;
+            if (record.blank)
+            {
+                send(runStart, recordStart);
+                recordStart = runStart = record.end;
+                continue;
+            }
+
+            if (headerPending)
+            {
+                headerPending = false;
+                std::vector<std::string> names = parseHeader(buffer.data() + recordStart, buffer.data() + record.end, options.format);
+                recordStart = runStart = record.end;
+                if (!beginCopy(names))
+                {
+                    failed = true;
+                }
+                continue;
+            }
+
+            fileRow++;
+            std::string problem;
+            if (!record.complete && options.format == Format::Csv && std::count(buffer.data() + recordStart, buffer.data() + record.end, '"') % 2)
+            {
+                problem = "unterminated quoted field";
+            }
+            else if (record.fields != expectedFields)
+            {
+                problem = "expected " + std::to_string(expectedFields) + " fields, found " + std::to_string(record.fields);
+            }
+
+            if (!problem.empty())
+            {
+                // The row is left out of the stream; rows after it keep flowing unless bad rows abort
+                send(runStart, recordStart);
+                recordStart = runStart = record.end;
+                progress.report(fileRow, "line " + std::to_string(line) + ": " + problem);
+                if (!options.skipBadRows || static_cast<long long>(progress.skippedRows.size()) >= MaxMalformedRows)
+                {
+                    error = options.skipBadRows ? "too many malformed rows" : "row " + std::to_string(fileRow) + ", line " + std::to_string(line) + ": " + problem;
+                    failed = true;
+                    break;
+                }
+                progress.skippedRows.push_back(fileRow);
+                progress.skipped++;
+                continue;
+            }
+
+            recordStart = record.end;
+            progress.rows++;
+            if (!record.complete)
+            {
+                // The last record has no newline; COPY needs one
+                send(runStart, recordStart);
+                runStart = recordStart;
+                if (!failed && PQputCopyData(conn, "\n", 1) != 1)
+                {
+                    error = PQerrorMessage(conn);
+                    failed = true;
+                }
+            }
+        }
+        if (failed)
+            break;
+
+        send(runStart, recordStart);
+        std::memmove(buffer.data(), buffer.data() + recordStart, filled - recordStart);
+        filled -= recordStart;
+        if (endOfFile && filled == 0)
+            break;
+    }
+    std::fclose(file);
+
+    // Ending the COPY with an error message makes the server abort it
+    if (copying)
+    {
+        const char *abort = failed || progress.stop ? "import aborted by client" : nullptr;
+        if (PQputCopyEnd(conn, abort) != 1 && !failed)
+        {
+            error = PQerrorMessage(conn);
+            failed = true;
+        }
+    }
+
+    // The COPY's own result carries the row count, or the failing line
+    PGresult *result;
+    while ((result = PQgetResult(conn)))
+    {
+        if (PQresultStatus(result) == PGRES_COMMAND_OK && copying)
+        {
+            progress.rows = std::atoll(PQcmdTuples(result));
+        }
+        else if (PQresultStatus(result) != PGRES_COMMAND_OK && !failed && !progress.stop)
+        {
+            const char *message = PQresultErrorField(result, PG_DIAG_MESSAGE_PRIMARY);
+            long long row = progress.fileRow(copyLine(PQresultErrorField(result, PG_DIAG_CONTEXT)));
+            error = std::string(message ? message : PQresultErrorMessage(result)) + (row > 0 ? " (row " + std::to_string(row) + ")" : "");
+            progress.report(row, error);
+            failed = true;
+        }
+        PQclear(result);
+    }
+
+    bool committed = false;
+    if (!failed && !progress.stop && !headerPending)
+    {
+        result = PQexec(conn, "COMMIT");
+        committed = PQresultStatus(result) == PGRES_COMMAND_OK;
+        if (!committed)
+        {
+            error = PQresultErrorMessage(result);
+        }
+        PQclear(result);
+    }
+    else if (headerPending && !failed && !progress.stop)
+    {
+        error = "the file is empty";
+    }
+    if (PQtransactionStatus(conn) != PQTRANS_IDLE)
+    {
+        PQclear(PQexec(conn, "ROLLBACK"));
+    }
+    // libpq's default receiver ignores its argument
+    PQsetNoticeReceiver(conn, previousReceiver, nullptr);
+
+    if (!committed && !progress.stop)
+    {
+        std::cerr << "Import failed: " << error << std::endl;
+    }
+    return committed;
+}
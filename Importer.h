@@ -0,0 +1,105 @@
+#pragma once
+
+// Standard library includes
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "ConnectionPool.h"
+
+// Loads a CSV or TSV file into a table with COPY ... FROM STDIN inside one
+// transaction on a background connection. The worker reads the file in large
+// blocks and splits it into records without copying them: runs of well-formed
+// records go to PQputCopyData straight from the read buffer, so a send is one
+// call per megabyte rather than one per row.
+//
+// Rows whose field count does not match the column list are reported and left
+// out on the client. On PostgreSQL 17 and later, skipBadRows also asks the
+// server to skip rows with values that do not convert (ON_ERROR ignore), and its
+// notices are reported the same way. Any other error, or a cancel, rolls the
+// whole import back. Row numbers in reports count data rows in the file, from 1.
+class Importer
+{
+  public:
+    enum class Format
+    {
+        Csv, // RFC 4180, quoted fields may span lines
+        Tsv, // COPY text format: tab separated, backslash escapes, \N for NULL
+    };
+
+    struct Options
+    {
+        Format format = Format::Csv;
+        bool header = true;      // First row names the target columns
+        bool skipBadRows = true; // Otherwise the first bad row aborts the import
+    };
+
+    struct RowError
+    {
+        long long row = 0;
+        std::string message;
+    };
+
+    using Finished = std::function<void(bool committed)>;
+
+    // Constructor/Destructor
+    explicit Importer(ConnectionPool *pool);
+    ~Importer();
+
+    // Main public interface; relation is quoted, columns are used when the file has no header
+    bool start(const std::string &relation, const std::vector<std::string> &columns, const std::string &path, const Options &options, Finished finished = nullptr);
+    void cancel();
+    bool isRunning() const { return running; }
+
+    // Progress, readable from the UI thread while the import runs
+    long long rowsSent() const;
+    long long rowsSkipped() const;
+    uint64_t bytesRead() const;
+    uint64_t fileBytes() const;
+    double elapsedSeconds() const;
+    double rowsPerSecond() const;
+    std::vector<RowError> rowErrors() const;
+    const std::string &status() const { return statusText; }
+
+    static Format formatForPath(const std::string &path);
+
+  private:
+    static constexpr size_t MaxReportedErrors = 100;
+    static constexpr long long MaxMalformedRows = 10000;
+
+    // Shared with the running job, which may outlive the importer by one rolled back COPY
+    struct Progress
+    {
+        std::atomic<long long> rows{0};
+        std::atomic<long long> skipped{0};
+        std::atomic<uint64_t> bytes{0};
+        std::atomic<uint64_t> fileSize{0};
+        std::atomic<bool> stop{false};
+        uint64_t startNs = 0;
+        std::atomic<uint64_t> endNs{0};
+
+        // Client-side skips in file order, for mapping the server's line numbers back to the file
+        std::vector<long long> skippedRows;
+        std::vector<RowError> errors;
+        mutable std::mutex errorsMutex;
+        void report(long long row, const std::string &message);
+        long long fileRow(long long sentRow) const;
+    };
+
+    ConnectionPool *pool;
+    std::shared_ptr<Progress> progress;
+    bool running = false;
+    std::string statusText;
+
+    static bool copyFromFile(PGconn *conn, const std::string &relation, const std::vector<std::string> &columns, const std::string &path, const Options &options, Progress &progress, std::string &error);
+    static std::vector<std::string> parseHeader(const char *begin, const char *end, Format format);
+    static void onNotice(void *arg, const PGresult *result);
+};
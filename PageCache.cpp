@@ -0,0 +1,92 @@
+#include "PageCache.h"
+
+PageCache::PageCache(size_t budgetBytes) : budgetBytes(budgetBytes) {}
+
+bool PageCache::find(const std::string &key, Entry &entry)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    lru.splice(lru.begin(), lru, it->second);
+    entry = it->second->entry;
+    return true;
+}
+
+bool PageCache::contains(const std::string &key) const { return index.count(key) > 0; }
+
+void PageCache::insert(const std::string &table, const std::string &key, Entry entry, uint64_t expectedGeneration)
+{
+    if (expectedGeneration != invalidations || !entry.page)
+        return;
+
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        erase(it->second);
+    }
+
+    size_t bytes = entry.page->memoryBytes() + key.size();
+    if (bytes > budgetBytes)
+        return;
+
+    lru.push_front({table, key, std::move(entry), bytes, expectedGeneration});
+    index[key] = lru.begin();
+    usedBytes += bytes;
+    evict();
+}
+
+void PageCache::invalidate(const std::string &table)
+{
+    invalidations++;
+    for (auto it = lru.begin(); it != lru.end();)
+    {
+        auto next = std::next(it);
+        if (it->table == table)
+        {
+            erase(it);
+        }
+        it = next;
+    }
+}
+
+void PageCache::clear()
+{
+    invalidations++;
+    lru.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+void PageCache::visit(const Visitor &visitor) const
+{
+    for (const Node &node : lru)
+    {
+        visitor(node.table, node.key, node.entry, node.generation);
+    }
+}
+
+void PageCache::setBudget(size_t bytes)
+{
+    budgetBytes = bytes;
+    evict();
+}
+
+void PageCache::erase(std::list<Node>::iterator it)
+{
+    usedBytes -= it->bytes;
+    index.erase(it->key);
+    lru.erase(it);
+}
+
+void PageCache::evict()
+{
+    while (usedBytes > budgetBytes && !lru.empty())
+    {
+        erase(std::prev(lru.end()));
+    }
+}
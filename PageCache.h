@@ -0,0 +1,73 @@
+#pragma once
+
+// Standard library includes
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Project includes
+#include "ResultStore.h"
+
+// LRU cache of result pages shared by all table views. Pages are keyed by their
+// query shape (table, filters, sort column and direction, page cursor) and
+// evicted least-recently-used first once the memory budget is exceeded.
+class PageCache
+{
+  public:
+    struct Entry
+    {
+        std::shared_ptr<const ResultStore> page;
+        bool moreRows = false;
+    };
+
+    // Constructor
+    PageCache(size_t budgetBytes = 256u << 20);
+
+    // Main public interface
+    bool find(const std::string &key, Entry &entry);
+    bool contains(const std::string &key) const;
+    void insert(const std::string &table, const std::string &key, Entry entry, uint64_t expectedGeneration);
+    void invalidate(const std::string &table);
+    void clear();
+
+    // Pages fetched before an invalidation must not be inserted after it
+    uint64_t generation() const { return invalidations; }
+
+    // Starts a new generation without dropping anything, so in-flight fetches from before it are not inserted
+    uint64_t barrier() { return ++invalidations; }
+
+    // Visits pages most recently used first, with the generation they were fetched in
+    using Visitor = std::function<void(const std::string &table, const std::string &key, const Entry &entry, uint64_t generation)>;
+    void visit(const Visitor &visitor) const;
+
+    // Budget and statistics
+    void setBudget(size_t bytes);
+    size_t budget() const { return budgetBytes; }
+    size_t memoryBytes() const { return usedBytes; }
+    uint64_t hitCount() const { return hits; }
+    uint64_t missCount() const { return misses; }
+
+  private:
+    struct Node
+    {
+        std::string table;
+        std::string key;
+        Entry entry;
+        size_t bytes = 0;
+        uint64_t generation = 0;
+    };
+
+    std::list<Node> lru; // Most recently used first
+    std::unordered_map<std::string, std::list<Node>::iterator> index;
+    size_t budgetBytes;
+    size_t usedBytes = 0;
+    uint64_t invalidations = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    void erase(std::list<Node>::iterator it);
+    void evict();
+};
@@ -0,0 +1,347 @@
+#include "QueryExecutor.h"
+#include "Trace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+// Sends cancel requests in order on one thread of its own. It drains its queue
+// before it stops, so executors waiting on a request are always released.
+class CancelSender
+{
+  public:
+    using Sent = std::function<void()>;
+
+    CancelSender() : thread(&CancelSender::run, this) {}
+
+    ~CancelSender()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+    void send(std::shared_ptr<PGcancel> handle, Sent sent)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.push_back({std::move(handle), std::move(sent)});
+        }
+        wake.notify_one();
+    }
+
+  private:
+    struct Request
+    {
+        std::shared_ptr<PGcancel> handle;
+        Sent sent;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    bool stopping = false;
+    std::thread thread;
+
+    void run()
+    {
+        Trace::setThreadName("cancel sender");
+        while (true)
+        {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !requests.empty(); });
+                if (requests.empty())
+                    return;
+                request = std::move(requests.front());
+                requests.pop_front();
+            }
+
+            char errbuf[256];
+            if (!PQcancel(request.handle.get(), errbuf, sizeof(errbuf)))
+            {
+                std::cerr << "Cancel request failed: " << errbuf << std::endl;
+            }
+            request.sent();
+        }
+    }
+};
+
+CancelSender &cancelSender()
+{
+    static CancelSender sender;
+    return sender;
+}
+} // namespace
+
+std::atomic<void (*)()> QueryExecutor::wakeHandler{nullptr};
+
+QueryExecutor::QueryExecutor(PGconn *conn, const std::string &connInfo) : conn(conn), connInfo(connInfo) { worker = std::thread(&QueryExecutor::run, this); }
+
+QueryExecutor::~QueryExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    // The sender calls back into this executor until its requests are out
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this] { return cancelsInFlight == 0; });
+    }
+    cancelHandle.reset();
+    PQfinish(conn);
+}
+
+void QueryExecutor::submit(const void *owner, Work work)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({owner, std::move(work), Trace::now()});
+    }
+    wake.notify_one();
+}
+
+void QueryExecutor::post(const void *owner, Completion completion)
+{
+    // Called from inside a running job to hand back partial results early
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running && runningOwner == owner && runningDiscarded)
+        {
+            return;
+        }
+        completions.push_back({owner, std::move(completion)});
+    }
+    wakeUi();
+}
+
+void QueryExecutor::setWakeHandler(void (*handler)()) { wakeHandler = handler; }
+
+void QueryExecutor::wakeUi()
+{
+    // The render loop may be asleep; completions and busy state are picked up on its next frame
+    if (void (*handler)() = wakeHandler.load())
+    {
+        handler();
+    }
+}
+
+void QueryExecutor::poll()
+{
+    // Swap the queue out so completions can submit new work without deadlocking
+    std::deque<Done> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ready.swap(completions);
+    }
+
+    for (auto &done : ready)
+    {
+        if (done.completion)
+        {
+            done.completion();
+        }
+    }
+}
+
+void QueryExecutor::discard(const void *owner)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    discardLocked(owner);
+}
+
+void QueryExecutor::cancel(const void *owner)
+{
+    // Never blocks: the request goes out from the sender thread, and until it has the worker holds back its next
+    // job; a request that arrives once the query is done is ignored by the idle backend
+    std::shared_ptr<PGcancel> handle;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        discardLocked(owner);
+        if (!running || runningOwner != owner || !cancelHandle)
+            return;
+        handle = cancelHandle;
+        cancelsInFlight++;
+    }
+
+    cancelSender().send(std::move(handle),
+                        [this]()
+                        {
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                cancelsInFlight--;
+                            }
+                            wake.notify_all();
+                        });
+}
+
+void QueryExecutor::discardLocked(const void *owner)
+{
+    jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [owner](const Job &job) { return job.owner == owner; }), jobs.end());
+    completions.erase(std::remove_if(completions.begin(), completions.end(), [owner](const Done &done) { return done.owner == owner; }), completions.end());
+    if (running && runningOwner == owner)
+    {
+        runningDiscarded = true;
+    }
+}
+
+bool QueryExecutor::isBusy(const void *owner) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!owner)
+    {
+        return running || !jobs.empty();
+    }
+    if (running && runningOwner == owner && !runningDiscarded)
+    {
+        return true;
+    }
+    return std::any_of(jobs.begin(), jobs.end(), [owner](const Job &job) { return job.owner == owner; });
+}
+
+size_t QueryExecutor::pendingJobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return jobs.size() + (running ? 1 : 0);
+}
+
+void QueryExecutor::checkHealth()
+{
+    // An empty query is the cheapest round trip; a dead server marks the connection bad
+    submit(this,
+           [this](PGconn *conn) -> Completion
+           {
+               PQclear(PQexec(conn, ""));
+               ensureConnection();
+               return nullptr;
+           });
+}
+
+void QueryExecutor::cancelQuery(PGconn *conn)
+{
+    char errbuf[256];
+    PGcancel *cancel = PQgetCancel(conn);
+    if (cancel && !PQcancel(cancel, errbuf, sizeof(errbuf)))
+    {
+        std::cerr << "Cancel request failed: " << errbuf << std::endl;
+    }
+    PQfreeCancel(cancel);
+}
+
+void QueryExecutor::run()
+{
+    Trace::setThreadName("query worker");
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || (!jobs.empty() && cancelsInFlight == 0); });
+            if (stopping)
+            {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            running = true;
+            runningOwner = job.owner;
+            runningDiscarded = false;
+        }
+
+        // Time spent queued behind other jobs shows pool contention
+        uint64_t start = Trace::now();
+        Trace::record("queue", "executor", job.queuedNs, start);
+        bool wasHealthy = healthy;
+        ensureConnection();
+        Completion completion = job.work(conn);
+        Trace::record("job", "executor", start, Trace::now());
+
+        bool handedBack = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!runningDiscarded && completion)
+            {
+                completions.push_back({job.owner, std::move(completion)});
+                handedBack = true;
+            }
+            running = false;
+            runningOwner = nullptr;
+            runningDiscarded = false;
+        }
+
+        // A job that hands nothing back and leaves the connection as it was changes nothing on screen
+        if (handedBack || healthy != wasHealthy)
+        {
+            wakeUi();
+        }
+    }
+}
+
+void QueryExecutor::ensureConnection()
+{
+    if (!conn)
+    {
+        conn = PQconnectdb(connInfo.c_str());
+        statementCache.reset();
+    }
+    else if (PQstatus(conn) != CONNECTION_OK)
+    {
+        // Prepared statements and session settings died with the old session
+        std::cerr << "Connection lost, reconnecting: " << PQerrorMessage(conn) << std::endl;
+        PQreset(conn);
+        statementCache.reset();
+        appliedTimeout = -1;
+        reconnects++;
+    }
+    else if (cancelHandle)
+    {
+        applySessionSettings();
+        return;
+    }
+
+    healthy = PQstatus(conn) == CONNECTION_OK;
+    if (!healthy)
+    {
+        std::cerr << "Connection failed: " << PQerrorMessage(conn) << std::endl;
+        return;
+    }
+
+    // A new session gets a new backend, and cancel requests must name it
+    std::shared_ptr<PGcancel> handle(PQgetCancel(conn), PQfreeCancel);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(cancelHandle, handle);
+    }
+    applySessionSettings();
+}
+
+void QueryExecutor::applySessionSettings()
+{
+    int timeout = statementTimeout;
+    if (timeout < 0 || timeout == appliedTimeout)
+        return;
+
+    std::string sql = "SET statement_timeout = " + std::to_string(timeout);
+    PGresult *result = PQexec(conn, sql.c_str());
+    if (PQresultStatus(result) == PGRES_COMMAND_OK)
+    {
+        appliedTimeout = timeout;
+    }
+    else
+    {
+        std::cerr << "Could not set statement_timeout: " << PQerrorMessage(conn) << std::endl;
+    }
+    PQclear(result);
+}
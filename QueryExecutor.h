@@ -0,0 +1,129 @@
+#pragma once
+
+// Standard library includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "StatementCache.h"
+
+// SQL text plus its text-format parameters; paramTypes may be left empty to let
+// the server infer them. resultFormat 1 asks for binary results.
+struct SqlQuery
+{
+    std::string sql;
+    std::vector<std::string> params;
+    std::vector<Oid> paramTypes;
+    int resultFormat = 0;
+
+    // Appends a parameter and returns its placeholder; type 0 lets the server infer it
+    std::string bind(std::string value, Oid type = 0)
+    {
+        params.push_back(std::move(value));
+        paramTypes.push_back(type);
+        return "$" + std::to_string(params.size());
+    }
+};
+
+// Runs libpq work on a dedicated worker thread so the render loop never blocks.
+// Each job gets exclusive use of the connection and returns a completion that
+// is handed back to the UI thread through poll(). The executor owns its
+// connection: when given none it connects on the worker, and a connection
+// found broken before a job is reset.
+//
+// cancel() drops an owner's queued jobs and has a cancel request sent for its
+// running one, so superseded work stops on the server instead of holding the
+// connection. A cancel request opens its own connection to the server, so it is
+// sent from a separate thread; the worker starts its next job only once the
+// request is out, so it cannot cancel that job instead. Session settings such
+// as statement_timeout are applied before the next job and again after every
+// reconnect.
+class QueryExecutor
+{
+  public:
+    using Completion = std::function<void()>;
+    using Work = std::function<Completion(PGconn *)>;
+
+    // Constructor/Destructor
+    QueryExecutor(PGconn *conn, const std::string &connInfo = "");
+    ~QueryExecutor();
+
+    // Main public interface
+    void submit(const void *owner, Work work);
+    void post(const void *owner, Completion completion);
+    void poll();
+    void discard(const void *owner);
+    void cancel(const void *owner);
+    bool isBusy(const void *owner = nullptr) const;
+    size_t pendingJobs() const;
+    void checkHealth();
+    static void cancelQuery(PGconn *conn);
+
+    // Milliseconds, 0 for none; negative leaves the server's default
+    void setStatementTimeout(int milliseconds) { statementTimeout = milliseconds; }
+
+    // Called from worker threads whenever a job hands back or posts a completion, or the connection's health changes
+    static void setWakeHandler(void (*handler)());
+
+    // Connection health as of the last job
+    bool isHealthy() const { return healthy; }
+    int reconnectCount() const { return reconnects; }
+
+    // Prepared statements of this executor's connection; used from jobs only
+    StatementCache &statements() { return statementCache; }
+    const StatementCache &statements() const { return statementCache; }
+
+  private:
+    struct Job
+    {
+        const void *owner;
+        Work work;
+        uint64_t queuedNs = 0;
+    };
+
+    struct Done
+    {
+        const void *owner;
+        Completion completion;
+    };
+
+    // Connection and worker state
+    PGconn *conn;
+    std::string connInfo;
+    StatementCache statementCache;
+    std::atomic<bool> healthy{true};
+    std::atomic<int> reconnects{0};
+    std::atomic<int> statementTimeout{-1};
+    int appliedTimeout = -1;          // Worker only
+    std::shared_ptr<PGcancel> cancelHandle; // Replaced by the worker under the mutex when the connection changes
+    int cancelsInFlight = 0;
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Queues shared between the UI thread and the worker
+    std::deque<Job> jobs;
+    std::deque<Done> completions;
+    bool running = false;
+    const void *runningOwner = nullptr;
+    bool runningDiscarded = false;
+
+    static std::atomic<void (*)()> wakeHandler;
+    static void wakeUi();
+
+    void run();
+    void ensureConnection();
+    void applySessionSettings();
+    void discardLocked(const void *owner);
+};
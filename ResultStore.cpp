@@ -0,0 +1,971 @@
+#include "ResultStore.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+// Type OIDs from pg_type.h; libpq does not export them to clients
+constexpr Oid BoolOid = 16;
+constexpr Oid ByteaOid = 17;
+constexpr Oid CharOid = 18;
+constexpr Oid NameOid = 19;
+constexpr Oid Int8Oid = 20;
+constexpr Oid Int2Oid = 21;
+constexpr Oid Int4Oid = 23;
+constexpr Oid TextOid = 25;
+constexpr Oid OidOid = 26;
+constexpr Oid JsonOid = 114;
+constexpr Oid Float4Oid = 700;
+constexpr Oid Float8Oid = 701;
+constexpr Oid BpcharOid = 1042;
+constexpr Oid VarcharOid = 1043;
+constexpr Oid DateOid = 1082;
+constexpr Oid TimeOid = 1083;
+constexpr Oid TimestampOid = 1114;
+constexpr Oid TimestamptzOid = 1184;
+constexpr Oid NumericOid = 1700;
+constexpr Oid UuidOid = 2950;
+constexpr Oid JsonbOid = 3802;
+
+// Postgres counts dates from 2000-01-01, the Unix epoch is 10957 days earlier
+constexpr int64_t PostgresEpochDays = 10957;
+constexpr int64_t MicrosPerDay = 86400000000LL;
+
+constexpr uint16_t NumericNegative = 0x4000;
+constexpr uint16_t NumericNaN = 0xC000;
+constexpr uint16_t NumericPositiveInfinity = 0xD000;
+constexpr uint16_t NumericNegativeInfinity = 0xF000;
+
+// Binary results arrive in network byte order
+uint16_t readUint16(const char *bytes)
+{
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(bytes);
+    return static_cast<uint16_t>((b[0] << 8) | b[1]);
+}
+
+uint32_t readUint32(const char *bytes)
+{
+    const unsigned char *b = reinterpret_cast<const unsigned char *>(bytes);
+    return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+
+uint64_t readUint64(const char *bytes) { return (uint64_t(readUint32(bytes)) << 32) | readUint32(bytes + 4); }
+
+// snprintf-style sink: writes what fits, counts everything
+struct Writer
+{
+    char *out;
+    size_t size;
+    size_t length = 0;
+
+    void put(char c)
+    {
+        if (length + 1 < size)
+            out[length] = c;
+        length++;
+    }
+
+    void put(const char *text, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+            put(text[i]);
+    }
+
+    void put(const char *text) { put(text, strlen(text)); }
+
+    template <typename... Args> void format(const char *fmt, Args... args)
+    {
+        char buffer[64];
+        int count = snprintf(buffer, sizeof(buffer), fmt, args...);
+        put(buffer, static_cast<size_t>(std::max(count, 0)));
+    }
+
+    size_t finish()
+    {
+        if (size > 0)
+            out[std::min(length, size - 1)] = '\0';
+        return length;
+    }
+};
+
+// Days since 1970-01-01 to a proleptic Gregorian date
+void civilFromDays(int64_t days, int64_t &year, unsigned &month, unsigned &day)
+{
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = static_cast<unsigned>(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned shifted = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * shifted + 2) / 5 + 1;
+    month = shifted < 10 ? shifted + 3 : shifted - 9;
+    year = static_cast<int64_t>(yearOfEra) + era * 400 + (month <= 2);
+}
+
+// Returns true for BC dates, whose suffix goes after any time part
+bool writeDate(Writer &writer, int64_t postgresDays)
+{
+    int64_t year;
+    unsigned month;
+    unsigned day;
+    civilFromDays(postgresDays + PostgresEpochDays, year, month, day);
+    bool bc = year <= 0;
+    writer.format("%04lld-%02u-%02u", static_cast<long long>(bc ? 1 - year : year), month, day);
+    return bc;
+}
+
+void writeTime(Writer &writer, int64_t micros)
+{
+    int64_t seconds = micros / 1000000;
+    int fraction = static_cast<int>(micros % 1000000);
+    writer.format("%02d:%02d:%02d", static_cast<int>(seconds / 3600), static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    if (fraction == 0)
+        return;
+
+    // Trailing zeros of the fraction are dropped, as the server does
+    char digits[8];
+    snprintf(digits, sizeof(digits), "%06d", fraction);
+    size_t count = 6;
+    while (digits[count - 1] == '0')
+        count--;
+    writer.put('.');
+    writer.put(digits, count);
+}
+
+void writeTimestamp(Writer &writer, int64_t micros, bool withZone)
+{
+    if (micros == std::numeric_limits<int64_t>::max() || micros == std::numeric_limits<int64_t>::min())
+    {
+        writer.put(micros > 0 ? "infinity" : "-infinity");
+        return;
+    }
+
+    int64_t days = micros / MicrosPerDay;
+    int64_t timeOfDay = micros % MicrosPerDay;
+    if (timeOfDay < 0)
+    {
+        days--;
+        timeOfDay += MicrosPerDay;
+    }
+
+    bool bc = writeDate(writer, days);
+    writer.put(' ');
+    writeTime(writer, timeOfDay);
+    // Binary timestamptz values are UTC instants; they are shown in UTC rather than the session time zone
+    if (withZone)
+        writer.put("+00");
+    if (bc)
+        writer.put(" BC");
+}
+
+void writeReal(Writer &writer, double value, bool singlePrecision)
+{
+    if (std::isnan(value))
+    {
+        writer.put("NaN");
+        return;
+    }
+    if (std::isinf(value))
+    {
+        writer.put(value > 0 ? "Infinity" : "-Infinity");
+        return;
+    }
+
+    // Shortest precision that round-trips, so the text can be bound back as a parameter
+    char buffer[32];
+    int precision = singlePrecision ? 6 : 15;
+    int maxPrecision = singlePrecision ? 9 : 17;
+    for (; precision < maxPrecision; precision++)
+    {
+        snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+        double parsed = strtod(buffer, nullptr);
+        if (singlePrecision ? static_cast<float>(parsed) == static_cast<float>(value) : parsed == value)
+            break;
+    }
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    writer.put(buffer);
+}
+
+void writeHex(Writer &writer, const char *bytes, size_t count)
+{
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned char byte = static_cast<unsigned char>(bytes[i]);
+        writer.put(digits[byte >> 4]);
+        writer.put(digits[byte & 15]);
+    }
+}
+
+void writeUuid(Writer &writer, std::string_view bytes)
+{
+    if (bytes.size() != 16)
+        return;
+    writeHex(writer, bytes.data(), 4);
+    writer.put('-');
+    writeHex(writer, bytes.data() + 4, 2);
+    writer.put('-');
+    writeHex(writer, bytes.data() + 6, 2);
+    writer.put('-');
+    writeHex(writer, bytes.data() + 8, 2);
+    writer.put('-');
+    writeHex(writer, bytes.data() + 10, 6);
+}
+
+// Binary numeric: ndigits, weight, sign and dscale, then base-10000 digits
+struct NumericView
+{
+    int ndigits = 0;
+    int weight = 0;
+    uint16_t sign = 0;
+    int dscale = 0;
+    const char *digits = nullptr;
+
+    explicit NumericView(std::string_view bytes)
+    {
+        if (bytes.size() < 8)
+            return;
+        ndigits = static_cast<int16_t>(readUint16(bytes.data()));
+        weight = static_cast<int16_t>(readUint16(bytes.data() + 2));
+        sign = readUint16(bytes.data() + 4);
+        dscale = static_cast<int16_t>(readUint16(bytes.data() + 6));
+        ndigits = std::min(ndigits, static_cast<int>((bytes.size() - 8) / 2));
+        digits = bytes.data() + 8;
+    }
+
+    int digit(int i) const { return i >= 0 && i < ndigits ? readUint16(digits + 2 * i) : 0; }
+    bool isSpecial() const { return sign == NumericNaN || sign == NumericPositiveInfinity || sign == NumericNegativeInfinity; }
+    bool isZero() const { return ndigits == 0; }
+
+    // Total order matching the server: -Infinity < finite values < Infinity < NaN
+    int rank() const
+    {
+        switch (sign)
+        {
+        case NumericNegativeInfinity:
+            return -2;
+        case NumericPositiveInfinity:
+            return 2;
+        case NumericNaN:
+            return 3;
+        default:
+            return isZero() ? 0 : sign == NumericNegative ? -1 : 1;
+        }
+    }
+};
+
+void writeNumeric(Writer &writer, std::string_view bytes)
+{
+    NumericView number(bytes);
+    switch (number.sign)
+    {
+    case NumericNaN:
+        writer.put("NaN");
+        return;
+    case NumericPositiveInfinity:
+        writer.put("Infinity");
+        return;
+    case NumericNegativeInfinity:
+        writer.put("-Infinity");
+        return;
+    }
+
+    if (number.sign == NumericNegative && !number.isZero())
+        writer.put('-');
+
+    if (number.weight < 0)
+    {
+        writer.put('0');
+    }
+    else
+    {
+        for (int i = 0; i <= number.weight; i++)
+        {
+            writer.format(i == 0 ? "%d" : "%04d", number.digit(i));
+        }
+    }
+
+    if (number.dscale <= 0)
+        return;
+
+    writer.put('.');
+    int written = 0;
+    for (int i = number.weight + 1; written < number.dscale; i++)
+    {
+        char group[8];
+        snprintf(group, sizeof(group), "%04d", number.digit(i));
+        int count = std::min(4, number.dscale - written);
+        writer.put(group, count);
+        written += count;
+    }
+}
+
+int compareNumeric(std::string_view a, std::string_view b)
+{
+    NumericView x(a);
+    NumericView y(b);
+    int rankX = x.rank();
+    int rankY = y.rank();
+    if (rankX != rankY)
+        return rankX < rankY ? -1 : 1;
+    if (rankX == 0 || x.isSpecial())
+        return 0;
+
+    // Same sign: compare magnitudes by weight, then digit by digit
+    int magnitude = 0;
+    if (x.weight != y.weight)
+    {
+        magnitude = x.weight < y.weight ? -1 : 1;
+    }
+    else
+    {
+        for (int i = 0; i < std::max(x.ndigits, y.ndigits) && magnitude == 0; i++)
+        {
+            magnitude = x.digit(i) < y.digit(i) ? -1 : x.digit(i) > y.digit(i) ? 1 : 0;
+        }
+    }
+    return rankX < 0 ? -magnitude : magnitude;
+}
+
+template <typename T> int compareValues(T a, T b) { return a < b ? -1 : b < a ? 1 : 0; }
+} // namespace
+
+void ResultStore::assign(const PGresult *result, int maxRows)
+{
+    clear();
+
+    int numCols = PQnfields(result);
+    columns.resize(numCols);
+    for (int col = 0; col < numCols; col++)
+    {
+        columns[col].name = PQfname(result, col);
+        columns[col].type = PQftype(result, col);
+        columns[col].kind = kindFor(columns[col].type, PQfformat(result, col));
+        columns[col].jsonb = columns[col].type == JsonbOid && PQfformat(result, col) == 1;
+    }
+
+    append(result, maxRows);
+}
+
+void ResultStore::append(const PGresult *result, int maxRows)
+{
+    int numRows = PQntuples(result);
+    if (maxRows >= 0)
+    {
+        numRows = std::min(numRows, maxRows);
+    }
+    int numCols = std::min(PQnfields(result), columnCount());
+
+    // Size the arena once for the whole batch so cells are copied without reallocating;
+    // growth stays geometric so streamed batches do not recopy the arena each time
+    size_t batchBytes = 0;
+    for (int row = 0; row < numRows; row++)
+    {
+        for (int col = 0; col < numCols; col++)
+        {
+            if (usesArena(columns[col].kind))
+            {
+                batchBytes += PQgetlength(result, row, col);
+            }
+        }
+    }
+    if (arena.size() + batchBytes > arena.capacity())
+    {
+        arena.reserve(std::max(arena.size() + batchBytes, arena.capacity() * 2));
+    }
+    reserveRows(rows + numRows);
+
+    for (int col = 0; col < numCols; col++)
+    {
+        Column &column = columns[col];
+        for (int row = 0; row < numRows; row++)
+        {
+            int target = rows + row;
+            if (PQgetisnull(result, row, col))
+            {
+                setNull(column, target, true);
+                storeBytes(column, target, nullptr, 0);
+            }
+            else
+            {
+                decodeCell(column, target, PQgetvalue(result, row, col), PQgetlength(result, row, col));
+            }
+        }
+    }
+
+    rows += numRows;
+}
+
+void ResultStore::append(const ResultStore &batch)
+{
+    if (columns.empty())
+    {
+        *this = batch;
+        return;
+    }
+
+    size_t base = arena.size();
+    if (base + batch.arena.size() > arena.capacity())
+    {
+        arena.reserve(std::max(base + batch.arena.size(), arena.capacity() * 2));
+    }
+    arena.insert(arena.end(), batch.arena.begin(), batch.arena.end());
+    reserveRows(rows + batch.rows);
+
+    int numCols = std::min(columnCount(), batch.columnCount());
+    for (int col = 0; col < numCols; col++)
+    {
+        Column &column = columns[col];
+        const Column &source = batch.columns[col];
+        for (int row = 0; row < batch.rows; row++)
+        {
+            int target = rows + row;
+            if (column.kind != source.kind)
+            {
+                // Pages fetched in different formats meet in text
+                if (!batch.isNull(row, col))
+                    setValue(target, col, batch.text(row, col));
+            }
+            else if (usesArena(column.kind))
+            {
+                column.offsets[target] = base + source.offsets[row];
+                column.lengths[target] = source.lengths[row];
+                column.firstLineLengths[target] = source.firstLineLengths[row];
+            }
+            else if (column.kind == Kind::Real)
+            {
+                column.reals[target] = source.reals[row];
+            }
+            else
+            {
+                column.ints[target] = source.ints[row];
+            }
+            if (batch.isNull(row, col))
+            {
+                setNull(column, target, true);
+            }
+        }
+    }
+
+    rows += batch.rows;
+}
+
+void ResultStore::setValue(int row, int col, std::string_view value)
+{
+    Column &column = columns[col];
+    if (column.kind != Kind::Text)
+    {
+        // Typed columns cannot hold arbitrary text
+        convertToText(col);
+    }
+
+    // Replaced bytes are left in place; the arena is rebuilt with the next page
+    storeBytes(column, row, value.data(), static_cast<uint32_t>(value.size()));
+    setNull(column, row, false);
+}
+
+void ResultStore::convertToText(int col)
+{
+    // Rows past rowCount() may already be reserved by an append in progress
+    Column &column = columns[col];
+    size_t reserved = column.kind == Kind::Real ? column.reals.size() : usesArena(column.kind) ? column.offsets.size() : column.ints.size();
+    std::vector<std::string> texts(reserved);
+    for (int i = 0; i < std::min(rows, static_cast<int>(reserved)); i++)
+    {
+        if (!isNull(i, col))
+            texts[i] = text(i, col);
+    }
+
+    column.kind = Kind::Text;
+    column.jsonb = false;
+    column.ints = {};
+    column.reals = {};
+    column.offsets.resize(reserved);
+    column.lengths.resize(reserved);
+    column.firstLineLengths.resize(reserved);
+    for (size_t i = 0; i < reserved; i++)
+    {
+        storeBytes(column, static_cast<int>(i), texts[i].data(), static_cast<uint32_t>(texts[i].size()));
+    }
+}
+
+void ResultStore::setCell(int row, int col, const ResultStore &source, int sourceRow, int sourceCol)
+{
+    Column &column = columns[col];
+    const Column &from = source.columns[sourceCol];
+    if (source.isNull(sourceRow, sourceCol))
+    {
+        setNull(column, row, true);
+        return;
+    }
+    if (column.kind != from.kind)
+    {
+        setValue(row, col, source.text(sourceRow, sourceCol));
+        return;
+    }
+
+    if (usesArena(column.kind))
+    {
+        std::string_view bytes = source.value(sourceRow, sourceCol);
+        storeBytes(column, row, bytes.data(), static_cast<uint32_t>(bytes.size()));
+    }
+    else if (column.kind == Kind::Real)
+    {
+        column.reals[row] = from.reals[sourceRow];
+    }
+    else
+    {
+        column.ints[row] = from.ints[sourceRow];
+    }
+    setNull(column, row, false);
+}
+
+void ResultStore::clear()
+{
+    arena.clear();
+    columns.clear();
+    rows = 0;
+}
+
+bool ResultStore::isBinary() const
+{
+    return std::any_of(columns.begin(), columns.end(), [](const Column &column) { return column.kind != Kind::Text || column.jsonb; });
+}
+
+bool ResultStore::decodesBinary(Oid type)
+{
+    switch (type)
+    {
+    case BoolOid:
+    case ByteaOid:
+    case CharOid:
+    case NameOid:
+    case Int8Oid:
+    case Int2Oid:
+    case Int4Oid:
+    case TextOid:
+    case OidOid:
+    case JsonOid:
+    case Float4Oid:
+    case Float8Oid:
+    case BpcharOid:
+    case VarcharOid:
+    case DateOid:
+    case TimeOid:
+    case TimestampOid:
+    case TimestamptzOid:
+    case NumericOid:
+    case UuidOid:
+    case JsonbOid:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t ResultStore::memoryBytes() const
+{
+    size_t bytes = arena.capacity();
+    for (const auto &column : columns)
+    {
+        bytes += column.offsets.capacity() * sizeof(uint64_t) + (column.lengths.capacity() + column.firstLineLengths.capacity()) * sizeof(uint32_t) + column.nullBits.capacity() * sizeof(uint64_t);
+        bytes += column.ints.capacity() * sizeof(int64_t) + column.reals.capacity() * sizeof(double);
+    }
+    return bytes;
+}
+
+std::string_view ResultStore::displayText(int row, int col, char *buffer, size_t size) const
+{
+    if (columns[col].kind == Kind::Text)
+    {
+        return firstLine(row, col);
+    }
+    if (isNull(row, col) || size == 0)
+    {
+        return {};
+    }
+
+    size_t length = formatCell(row, col, buffer, size);
+    if (length < size)
+    {
+        return std::string_view(buffer, length);
+    }
+
+    // Long bytea and numeric values are cut short with an ellipsis
+    if (size > 4)
+    {
+        memcpy(buffer + size - 4, "...", 4);
+    }
+    return std::string_view(buffer, size - 1);
+}
+
+std::string ResultStore::text(int row, int col) const
+{
+    if (isNull(row, col))
+    {
+        return {};
+    }
+    if (columns[col].kind == Kind::Text)
+    {
+        return std::string(value(row, col));
+    }
+
+    char buffer[64];
+    size_t length = formatCell(row, col, buffer, sizeof(buffer));
+    if (length < sizeof(buffer))
+    {
+        return std::string(buffer, length);
+    }
+
+    std::string out(length + 1, '\0');
+    formatCell(row, col, &out[0], out.size());
+    out.resize(length);
+    return out;
+}
+
+std::string_view ResultStore::textView(int row, int col, std::string &scratch) const
+{
+    if (isNull(row, col))
+    {
+        return {};
+    }
+    if (columns[col].kind == Kind::Text)
+    {
+        return value(row, col);
+    }
+
+    // The scratch buffer grows to the longest value formatted and is reused after that
+    scratch.resize(std::max<size_t>(scratch.capacity(), 64));
+    size_t length = formatCell(row, col, &scratch[0], scratch.size());
+    if (length >= scratch.size())
+    {
+        scratch.resize(length + 1);
+        formatCell(row, col, &scratch[0], scratch.size());
+    }
+    return std::string_view(scratch.data(), length);
+}
+
+int ResultStore::compare(int a, int b, int col) const
+{
+    bool aNull = isNull(a, col);
+    bool bNull = isNull(b, col);
+    if (aNull || bNull)
+    {
+        return static_cast<int>(aNull) - static_cast<int>(bNull);
+    }
+
+    const Column &column = columns[col];
+    switch (column.kind)
+    {
+    case Kind::Text:
+    case Kind::Uuid:
+    case Kind::Bytea:
+        return value(a, col).compare(value(b, col));
+    case Kind::Numeric:
+        return compareNumeric(value(a, col), value(b, col));
+    case Kind::Real:
+    {
+        // The server sorts NaN above every other value
+        double x = column.reals[a];
+        double y = column.reals[b];
+        if (std::isnan(x) || std::isnan(y))
+            return static_cast<int>(std::isnan(x)) - static_cast<int>(std::isnan(y));
+        return compareValues(x, y);
+    }
+    default:
+        return compareValues(column.ints[a], column.ints[b]);
+    }
+}
+
+void ResultStore::serialize(std::string &out) const
+{
+    BinaryWriter writer(out);
+    writer.value<int32_t>(rows);
+    writer.value<uint32_t>(columns.size());
+    writer.array(arena);
+    for (const auto &column : columns)
+    {
+        writer.bytes(column.name);
+        writer.value<Oid>(column.type);
+        writer.value<uint8_t>(static_cast<uint8_t>(column.kind));
+        writer.value<uint8_t>(column.jsonb);
+        writer.array(column.offsets);
+        writer.array(column.lengths);
+        writer.array(column.firstLineLengths);
+        writer.array(column.ints);
+        writer.array(column.reals);
+        writer.array(column.nullBits);
+    }
+}
+
+bool ResultStore::deserialize(std::string_view data)
+{
+    clear();
+    BinaryReader reader(data);
+    int32_t rowCount = 0;
+    uint32_t columnCount = 0;
+    if (!reader.value(rowCount) || !reader.value(columnCount) || !reader.array(arena) || rowCount < 0)
+        return false;
+
+    // Every array must match the row count and every cell must lie inside the arena, or the image is not used
+    size_t count = rowCount;
+    columns.resize(columnCount);
+    for (auto &column : columns)
+    {
+        uint8_t kind = 0;
+        uint8_t jsonb = 0;
+        reader.bytes(column.name);
+        reader.value(column.type);
+        reader.value(kind);
+        reader.value(jsonb);
+        reader.array(column.offsets);
+        reader.array(column.lengths);
+        reader.array(column.firstLineLengths);
+        reader.array(column.ints);
+        reader.array(column.reals);
+        reader.array(column.nullBits);
+        column.kind = static_cast<Kind>(kind);
+        column.jsonb = jsonb != 0;
+
+        bool valid = reader.ok() && kind <= static_cast<uint8_t>(Kind::Numeric) && column.nullBits.size() == (count + 63) / 64;
+        if (valid && usesArena(column.kind))
+        {
+            valid = column.offsets.size() == count && column.lengths.size() == count && column.firstLineLengths.size() == count;
+            for (size_t row = 0; valid && row < count; row++)
+            {
+                valid = column.offsets[row] <= arena.size() && column.lengths[row] <= arena.size() - column.offsets[row] && column.firstLineLengths[row] <= column.lengths[row];
+            }
+        }
+        else if (valid)
+        {
+            valid = (column.kind == Kind::Real ? column.reals.size() : column.ints.size()) == count;
+        }
+        if (!valid)
+        {
+            clear();
+            return false;
+        }
+    }
+    if (!reader.atEnd())
+    {
+        clear();
+        return false;
+    }
+    rows = rowCount;
+    return true;
+}
+
+void ResultStore::reserveRows(int totalRows)
+{
+    size_t words = (static_cast<size_t>(totalRows) + 63) / 64;
+    for (auto &column : columns)
+    {
+        if (usesArena(column.kind))
+        {
+            column.offsets.resize(totalRows);
+            column.lengths.resize(totalRows);
+            column.firstLineLengths.resize(totalRows);
+        }
+        else if (column.kind == Kind::Real)
+        {
+            column.reals.resize(totalRows);
+        }
+        else
+        {
+            column.ints.resize(totalRows);
+        }
+        column.nullBits.resize(words, 0);
+    }
+}
+
+void ResultStore::setNull(Column &column, int row, bool null)
+{
+    uint64_t bit = uint64_t(1) << (row & 63);
+    column.nullBits[row >> 6] = null ? column.nullBits[row >> 6] | bit : column.nullBits[row >> 6] & ~bit;
+}
+
+void ResultStore::storeBytes(Column &column, int row, const char *bytes, uint32_t length)
+{
+    if (!usesArena(column.kind))
+        return;
+
+    column.offsets[row] = arena.size();
+    column.lengths[row] = length;
+    column.firstLineLengths[row] = column.kind == Kind::Text && length > 0 ? firstLineLength(bytes, length) : 0;
+    if (length > 0)
+    {
+        arena.insert(arena.end(), bytes, bytes + length);
+    }
+}
+
+void ResultStore::decodeCell(Column &column, int row, const char *bytes, uint32_t length)
+{
+    switch (column.kind)
+    {
+    case Kind::Text:
+        // Binary jsonb is a version byte followed by the JSON text
+        if (column.jsonb && length > 0)
+        {
+            bytes++;
+            length--;
+        }
+        storeBytes(column, row, bytes, length);
+        break;
+    case Kind::Uuid:
+    case Kind::Bytea:
+    case Kind::Numeric:
+        storeBytes(column, row, bytes, length);
+        break;
+    case Kind::Int:
+        if (length == 2)
+            column.ints[row] = static_cast<int16_t>(readUint16(bytes));
+        else if (length == 4)
+            column.ints[row] = column.type == OidOid ? static_cast<int64_t>(readUint32(bytes)) : static_cast<int32_t>(readUint32(bytes));
+        else if (length == 8)
+            column.ints[row] = static_cast<int64_t>(readUint64(bytes));
+        break;
+    case Kind::Bool:
+        column.ints[row] = length > 0 && bytes[0] != 0;
+        break;
+    case Kind::Date:
+        column.ints[row] = length == 4 ? static_cast<int32_t>(readUint32(bytes)) : 0;
+        break;
+    case Kind::Time:
+    case Kind::Timestamp:
+    case Kind::TimestampTz:
+        column.ints[row] = length == 8 ? static_cast<int64_t>(readUint64(bytes)) : 0;
+        break;
+    case Kind::Real:
+        if (length == 4)
+        {
+            uint32_t bits = readUint32(bytes);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            column.reals[row] = value;
+        }
+        else if (length == 8)
+        {
+            uint64_t bits = readUint64(bytes);
+            memcpy(&column.reals[row], &bits, sizeof(double));
+        }
+        break;
+    }
+}
+
+size_t ResultStore::formatCell(int row, int col, char *buffer, size_t size) const
+{
+    const Column &column = columns[col];
+    Writer writer{buffer, size};
+    switch (column.kind)
+    {
+    case Kind::Text:
+    {
+        std::string_view bytes = value(row, col);
+        writer.put(bytes.data(), bytes.size());
+        break;
+    }
+    case Kind::Int:
+        writer.format("%lld", static_cast<long long>(column.ints[row]));
+        break;
+    case Kind::Bool:
+        writer.put(column.ints[row] ? 't' : 'f');
+        break;
+    case Kind::Real:
+        writeReal(writer, column.reals[row], column.type == Float4Oid);
+        break;
+    case Kind::Date:
+    {
+        int64_t days = column.ints[row];
+        if (days == std::numeric_limits<int32_t>::max() || days == std::numeric_limits<int32_t>::min())
+        {
+            writer.put(days > 0 ? "infinity" : "-infinity");
+        }
+        else if (writeDate(writer, days))
+        {
+            writer.put(" BC");
+        }
+        break;
+    }
+    case Kind::Time:
+        writeTime(writer, column.ints[row]);
+        break;
+    case Kind::Timestamp:
+    case Kind::TimestampTz:
+        writeTimestamp(writer, column.ints[row], column.kind == Kind::TimestampTz);
+        break;
+    case Kind::Uuid:
+        writeUuid(writer, value(row, col));
+        break;
+    case Kind::Bytea:
+    {
+        std::string_view bytes = value(row, col);
+        writer.put("\\x");
+        // Only what fits is hex-encoded, so previews of large blobs stay cheap
+        size_t fits = size > writer.length ? (size - writer.length) / 2 : 0;
+        writeHex(writer, bytes.data(), std::min(bytes.size(), fits));
+        writer.length += 2 * (bytes.size() - std::min(bytes.size(), fits));
+        break;
+    }
+    case Kind::Numeric:
+        writeNumeric(writer, value(row, col));
+        break;
+    }
+    return writer.finish();
+}
+
+ResultStore::Kind ResultStore::kindFor(Oid type, int format)
+{
+    if (format != 1)
+    {
+        return Kind::Text;
+    }
+
+    switch (type)
+    {
+    case BoolOid:
+        return Kind::Bool;
+    case Int8Oid:
+    case Int2Oid:
+    case Int4Oid:
+    case OidOid:
+        return Kind::Int;
+    case Float4Oid:
+    case Float8Oid:
+        return Kind::Real;
+    case DateOid:
+        return Kind::Date;
+    case TimeOid:
+        return Kind::Time;
+    case TimestampOid:
+        return Kind::Timestamp;
+    case TimestamptzOid:
+        return Kind::TimestampTz;
+    case UuidOid:
+        return Kind::Uuid;
+    case NumericOid:
+        return Kind::Numeric;
+    case CharOid:
+    case NameOid:
+    case TextOid:
+    case JsonOid:
+    case BpcharOid:
+    case VarcharOid:
+    case JsonbOid:
+        return Kind::Text;
+    default:
+        // Binary types without a decoder are at least shown as raw bytes
+        return Kind::Bytea;
+    }
+}
+
+uint32_t ResultStore::firstLineLength(const char *bytes, uint32_t length)
+{
+    // Cells render only their first line, so the span is found once at load time
+    const void *newline = memchr(bytes, '\n', length);
+    return newline ? static_cast<uint32_t>(static_cast<const char *>(newline) - bytes) : length;
+}
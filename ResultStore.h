@@ -0,0 +1,106 @@
+#pragma once
+
+// Standard library includes
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Columnar page of query results. Variable-length cells live in one shared arena;
+// each column keeps per-row offsets and lengths into it plus a NULL bitmap, so
+// a page costs a handful of allocations however many cells it holds, and SQL
+// NULL stays distinct from the string 'NULL'.
+//
+// Binary-format results are decoded by type OID: integers, booleans, dates and
+// timestamps land in an int64 buffer and floats in a double buffer, while uuid,
+// bytea and numeric keep their wire bytes. Text is produced only when a cell is
+// displayed or edited, and compare() orders cells by their native value.
+class ResultStore
+{
+  public:
+    enum class Kind
+    {
+        Text,
+        Int,
+        Real,
+        Bool,
+        Date,
+        Time,
+        Timestamp,
+        TimestampTz,
+        Uuid,
+        Bytea,
+        Numeric
+    };
+
+    // Filling
+    void assign(const PGresult *result, int maxRows = -1);
+    void append(const PGresult *result, int maxRows = -1);
+    void append(const ResultStore &batch);
+    void setValue(int row, int col, std::string_view value);
+    void setCell(int row, int col, const ResultStore &source, int sourceRow, int sourceCol);
+    void clear();
+
+    // Metadata
+    int rowCount() const { return rows; }
+    int columnCount() const { return static_cast<int>(columns.size()); }
+    const std::string &columnName(int col) const { return columns[col].name; }
+    Oid columnType(int col) const { return columns[col].type; }
+    Kind columnKind(int col) const { return columns[col].kind; }
+    bool isBinary() const;
+    static bool decodesBinary(Oid type);
+
+    // Cell access; views stay valid until the store is modified
+    bool isNull(int row, int col) const { return (columns[col].nullBits[row >> 6] >> (row & 63)) & 1; }
+    std::string_view value(int row, int col) const { return std::string_view(arena.data() + columns[col].offsets[row], columns[col].lengths[row]); }
+    std::string_view firstLine(int row, int col) const { return std::string_view(arena.data() + columns[col].offsets[row], columns[col].firstLineLengths[row]); }
+    int64_t intValue(int row, int col) const { return columns[col].ints[row]; }
+    double realValue(int row, int col) const { return columns[col].reals[row]; }
+    size_t memoryBytes() const;
+
+    // Text conversion: displayText() formats into the caller's buffer (truncating long
+    // values) and returns the first line; text() returns the full server-style text,
+    // and textView() the same without allocating for text columns or short values
+    std::string_view displayText(int row, int col, char *buffer, size_t size) const;
+    std::string text(int row, int col) const;
+    std::string_view textView(int row, int col, std::string &scratch) const;
+
+    // Typed three-way comparison; NULLs sort after every value
+    int compare(int a, int b, int col) const;
+
+    // Columnar image for the disk cache: the arena and each column's arrays as contiguous blocks
+    void serialize(std::string &out) const;
+    bool deserialize(std::string_view data);
+
+  private:
+    struct Column
+    {
+        std::string name;
+        Oid type = 0;
+        Kind kind = Kind::Text;
+        bool jsonb = false;
+        std::vector<uint64_t> offsets;
+        std::vector<uint32_t> lengths;
+        std::vector<uint32_t> firstLineLengths;
+        std::vector<int64_t> ints;
+        std::vector<double> reals;
+        std::vector<uint64_t> nullBits;
+    };
+
+    std::vector<char> arena;
+    std::vector<Column> columns;
+    int rows = 0;
+
+    void reserveRows(int totalRows);
+    void setNull(Column &column, int row, bool null);
+    void storeBytes(Column &column, int row, const char *bytes, uint32_t length);
+    void convertToText(int col);
+    void decodeCell(Column &column, int row, const char *bytes, uint32_t length);
+    size_t formatCell(int row, int col, char *buffer, size_t size) const;
+    static bool usesArena(Kind kind) { return kind == Kind::Text || kind == Kind::Uuid || kind == Kind::Bytea || kind == Kind::Numeric; }
+    static Kind kindFor(Oid type, int format);
+    static uint32_t firstLineLength(const char *bytes, uint32_t length);
+};
@@ -0,0 +1,226 @@
+#include "RowSorter.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace
+{
+// Sorts in chunks on up to eight threads, then merges neighbouring runs pairwise
+template <typename Item, typename Less> void parallelSort(std::vector<Item> &items, size_t threshold, Less less)
+{
+    size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), 8);
+    if (items.size() < threshold || threads < 2)
+    {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (size_t i = 0; i <= threads; i++)
+    {
+        bounds.push_back(items.size() * i / threads);
+    }
+
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&items, &less, begin = bounds[i], end = bounds[i + 1]] { std::sort(items.begin() + begin, items.begin() + end, less); });
+    }
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t width = 1; width < threads; width *= 2)
+    {
+        workers.clear();
+        for (size_t i = 0; i + width < threads; i += 2 * width)
+        {
+            size_t begin = bounds[i];
+            size_t middle = bounds[i + width];
+            size_t end = bounds[std::min(i + 2 * width, threads)];
+            workers.emplace_back([&items, &less, begin, middle, end] { std::inplace_merge(items.begin() + begin, items.begin() + middle, items.begin() + end, less); });
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+} // namespace
+
+void RowSorter::sort(const ResultStore &rows, const std::vector<Key> &keys, std::vector<int> &order)
+{
+    std::vector<KeyColumn> columns;
+    for (const auto &key : keys)
+    {
+        if (key.column >= 0 && key.column < rows.columnCount())
+        {
+            columns.push_back(buildKeyColumn(rows, key));
+        }
+    }
+
+    int count = rows.rowCount();
+    if (columns.empty())
+    {
+        order.resize(count);
+        for (int i = 0; i < count; i++)
+        {
+            order[i] = i;
+        }
+        return;
+    }
+
+    // Descending keys are inverted so every comparison is a plain unsigned less-than
+    const KeyColumn &first = columns.front();
+    std::vector<Item> items(count);
+    for (int i = 0; i < count; i++)
+    {
+        items[i] = {first.descending ? ~first.values[i] : first.values[i], i};
+    }
+
+    auto compareKey = [&rows](const KeyColumn &column, int a, int b) {
+        uint64_t x = column.values[a];
+        uint64_t y = column.values[b];
+        int cmp = x < y ? -1 : x > y ? 1 : 0;
+        if (cmp == 0 && tieNeedsCompare(column, x, a, b))
+        {
+            cmp = rows.compare(a, b, column.column);
+        }
+        return column.descending ? -cmp : cmp;
+    };
+
+    auto less = [&](const Item &a, const Item &b) {
+        if (a.key != b.key)
+            return a.key < b.key;
+        if (tieNeedsCompare(first, first.descending ? ~a.key : a.key, a.row, b.row))
+        {
+            int cmp = compareKey(first, a.row, b.row);
+            if (cmp != 0)
+                return cmp < 0;
+        }
+        for (size_t i = 1; i < columns.size(); i++)
+        {
+            int cmp = compareKey(columns[i], a.row, b.row);
+            if (cmp != 0)
+                return cmp < 0;
+        }
+        return a.row < b.row;
+    };
+
+    parallelSort(items, ParallelThreshold, less);
+
+    order.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        order[i] = items[i].row;
+    }
+}
+
+RowSorter::KeyColumn RowSorter::buildKeyColumn(const ResultStore &rows, const Key &key)
+{
+    KeyColumn column;
+    column.column = key.column;
+    column.descending = key.descending;
+
+    column.kind = rows.columnKind(key.column);
+    ResultStore::Kind kind = column.kind;
+
+    int count = rows.rowCount();
+    column.values.resize(count);
+    if (kind == ResultStore::Kind::Numeric)
+    {
+        column.inexact.resize(count);
+    }
+    std::string scratch;
+    for (int row = 0; row < count; row++)
+    {
+        if (rows.isNull(row, key.column))
+        {
+            column.values[row] = NullKey;
+            continue;
+        }
+
+        switch (kind)
+        {
+        case ResultStore::Kind::Text:
+        case ResultStore::Kind::Uuid:
+        case ResultStore::Kind::Bytea:
+        {
+            std::string_view bytes = rows.value(row, key.column);
+            column.values[row] = encodeBytes(bytes.data(), bytes.size());
+            break;
+        }
+        case ResultStore::Kind::Numeric:
+        {
+            // Correctly rounded parsing never reorders values, it only makes some of them tie;
+            // values with at most 15 significant digits never share a double with another value
+            std::string text(rows.textView(row, key.column, scratch));
+            column.values[row] = encodeReal(std::strtod(text.c_str(), nullptr));
+            size_t significant = text.find_first_of("123456789");
+            int digits = 0;
+            for (size_t i = significant; i < text.size(); i++)
+            {
+                digits += std::isdigit(static_cast<unsigned char>(text[i])) ? 1 : 0;
+            }
+            column.inexact[row] = significant != std::string::npos && digits > 15;
+            break;
+        }
+        case ResultStore::Kind::Real:
+            column.values[row] = encodeReal(rows.realValue(row, key.column));
+            break;
+        default:
+            column.values[row] = encodeInt(rows.intValue(row, key.column));
+            break;
+        }
+    }
+    return column;
+}
+
+bool RowSorter::tieNeedsCompare(const KeyColumn &column, uint64_t value, int a, int b)
+{
+    // NullKey is shared by NULL and the largest int64, so it is always checked in full
+    if (value == NullKey)
+        return true;
+
+    switch (column.kind)
+    {
+    case ResultStore::Kind::Text:
+    case ResultStore::Kind::Uuid:
+    case ResultStore::Kind::Bytea:
+        return (value & 0xFF) == 8;
+    case ResultStore::Kind::Numeric:
+        return column.inexact[a] || column.inexact[b];
+    default:
+        return false;
+    }
+}
+
+uint64_t RowSorter::encodeReal(double value)
+{
+    // NaN sorts above infinity but below NULL; -0 and +0 are equal
+    if (std::isnan(value))
+        return NullKey - 1;
+    if (value == 0)
+        value = 0;
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+}
+
+uint64_t RowSorter::encodeBytes(const char *bytes, size_t length)
+{
+    // Big-endian so the integer order matches memcmp; short values are zero padded, and the
+    // length byte after them orders a value before any longer value it is a prefix of
+    uint64_t key = 0;
+    for (size_t i = 0; i < 7; i++)
+    {
+        key = (key << 8) | (i < length ? static_cast<unsigned char>(bytes[i]) : 0);
+    }
+    return (key << 8) | std::min<size_t>(length, 8);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+// Standard library includes
+#include <cstdint>
+#include <vector>
+
+// Project includes
+#include "ResultStore.h"
+
+// Orders resident rows by one or more columns without touching cell text in the
+// common case. Each sort key column is first normalized into one uint64 per row
+// whose unsigned order matches the column's typed order: integers, booleans,
+// dates and timestamps by their sign-flipped int64, floats by their IEEE bits
+// (NaN greatest, as on the server), numeric by its nearest double, and text, uuid
+// and bytea by their first seven bytes big-endian followed by the length (capped
+// at eight). Only rows whose keys tie on an inexact encoding (long strings with a
+// shared prefix, numerics with more digits than a double holds) fall back to
+// ResultStore::compare().
+//
+// Ties are broken by row index, so the order is deterministic, and large sets are
+// sorted in chunks on several threads and merged.
+class RowSorter
+{
+  public:
+    struct Key
+    {
+        int column = 0;
+        bool descending = false;
+    };
+
+    // Fills order with the row indices of rows sorted by keys; keys naming columns
+    // the store does not have are ignored
+    static void sort(const ResultStore &rows, const std::vector<Key> &keys, std::vector<int> &order);
+
+  private:
+    struct KeyColumn
+    {
+        int column = 0;
+        bool descending = false;
+        ResultStore::Kind kind = ResultStore::Kind::Int;
+        std::vector<uint64_t> values;
+        std::vector<bool> inexact; // Numeric rows whose double may be shared by a different value
+    };
+
+    // First key folded in with the row so the hot comparison stays in one cache line
+    struct Item
+    {
+        uint64_t key;
+        int row;
+    };
+
+    static constexpr uint64_t NullKey = UINT64_MAX;
+    static constexpr size_t ParallelThreshold = 1 << 16;
+
+    static KeyColumn buildKeyColumn(const ResultStore &rows, const Key &key);
+    static bool tieNeedsCompare(const KeyColumn &column, uint64_t value, int a, int b);
+    static uint64_t encodeInt(int64_t value) { return static_cast<uint64_t>(value) ^ (uint64_t(1) << 63); }
+    static uint64_t encodeReal(double value);
+    static uint64_t encodeBytes(const char *bytes, size_t length);
+};
@@ -0,0 +1,599 @@
+#include "SchemaCatalog.h"
+#include "BinaryIO.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+// How long the listener waits before reconnecting to a server it lost
+constexpr int ListenRetryMillis = 5000;
+
+// Tables, partitioned tables, views, materialized views and foreign tables outside the system schemas
+constexpr const char *RelationFilter = "c.relkind IN ('r', 'p', 'v', 'm', 'f') AND n.nspname <> 'information_schema' AND n.nspname NOT LIKE 'pg\\_%'";
+
+double millisSince(std::chrono::steady_clock::time_point start) { return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+PGresult *executeCatalogQuery(PGconn *conn, StatementCache &statements, const SqlQuery &query)
+{
+    PGresult *result = statements.execute(conn, query);
+    if (PQresultStatus(result) != PGRES_TUPLES_OK)
+    {
+        std::cerr << "Catalog query failed: " << PQerrorMessage(conn) << std::endl;
+        PQclear(result);
+        return nullptr;
+    }
+    return result;
+}
+} // namespace
+
+SchemaCatalog::SchemaCatalog(ConnectionPool *pool) : pool(pool), snapshot(std::make_shared<Snapshot>())
+{
+    if (pipe(stopPipe) != 0)
+    {
+        std::cerr << "Catalog notifications unavailable: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    listener = std::make_unique<QueryExecutor>(nullptr, pool->connectionInfo());
+    listen();
+}
+
+SchemaCatalog::~SchemaCatalog()
+{
+    pool->discard(this);
+    if (listener)
+    {
+        // Ends the listening job, which the executor waits for
+        char stop = 0;
+        if (write(stopPipe[1], &stop, 1) != 1)
+        {
+            std::cerr << "Could not stop the catalog listener" << std::endl;
+        }
+        listener.reset();
+    }
+    for (int fd : stopPipe)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+}
+
+void SchemaCatalog::load()
+{
+    pool->discard(this);
+    int generation = ++loadGeneration;
+    loading = true;
+    refreshing = false;
+    refreshQueued = false;
+    loadStart = Clock::now();
+
+    QueryExecutor *executor = pool->foreground();
+    StatementCache *statements = &executor->statements();
+    executor->submit(this,
+                     [this, generation, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         // Names only, so the table list is usable before columns and indexes arrive
+                         std::vector<RelationPtr> relations;
+                         SnapshotPtr names = fetchRelations(conn, *statements, false, relations) ? buildSnapshot(std::move(relations), false) : nullptr;
+                         return [this, generation, names]()
+                         {
+                             if (generation != loadGeneration)
+                                 return;
+
+                             namesTime = millisSince(loadStart);
+                             apply(names);
+                             refresh();
+                         };
+                     });
+}
+
+void SchemaCatalog::refresh()
+{
+    if (refreshing)
+    {
+        refreshQueued = true;
+        return;
+    }
+
+    refreshing = true;
+    int generation = loadGeneration;
+    SnapshotPtr previous = snapshot;
+    QueryExecutor *background = pool->background();
+    StatementCache *statements = &background->statements();
+
+    background->submit(this,
+                       [this, generation, previous, statements](PGconn *conn) -> QueryExecutor::Completion
+                       {
+                           std::vector<RelationPtr> current;
+                           SnapshotPtr next = fetchRelations(conn, *statements, true, current) ? mergeDetails(conn, *statements, previous, current) : nullptr;
+                           return [this, generation, next]()
+                           {
+                               if (generation != loadGeneration)
+                                   return;
+
+                               refreshing = false;
+                               if (loading)
+                               {
+                                   loading = false;
+                                   loadTime = millisSince(loadStart);
+                               }
+                               apply(next);
+                               if (refreshQueued)
+                               {
+                                   refreshQueued = false;
+                                   refresh();
+                               }
+                           };
+                       });
+}
+
+void SchemaCatalog::poll()
+{
+    if (listener)
+    {
+        listener->poll();
+    }
+}
+
+void SchemaCatalog::listen()
+{
+    QueryExecutor *executor = listener.get();
+    int stop = stopPipe[0];
+    executor->submit(this,
+                     [this, executor, stop](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         bool listening = PQstatus(conn) == CONNECTION_OK;
+                         if (listening)
+                         {
+                             PGresult *result = PQexec(conn, (std::string("LISTEN ") + NotifyChannel).c_str());
+                             listening = PQresultStatus(result) == PGRES_COMMAND_OK;
+                             PQclear(result);
+                         }
+
+                         // Sleeps until the server sends something or the catalog goes away
+                         pollfd sockets[2] = {{stop, POLLIN, 0}, {PQsocket(conn), POLLIN, 0}};
+                         while (listening)
+                         {
+                             if (::poll(sockets, 2, -1) < 0 && errno != EINTR)
+                                 break;
+                             if (sockets[0].revents)
+                                 return nullptr;
+                             if (!sockets[1].revents)
+                                 continue;
+                             if (!PQconsumeInput(conn))
+                                 break;
+
+                             int notifications = 0;
+                             while (PGnotify *notify = PQnotifies(conn))
+                             {
+                                 notifications++;
+                                 PQfreemem(notify);
+                             }
+                             if (notifications > 0)
+                             {
+                                 // A load in progress reads the catalog afresh anyway
+                                 executor->post(this,
+                                                [this]()
+                                                {
+                                                    if (!loading)
+                                                    {
+                                                        refresh();
+                                                    }
+                                                });
+                             }
+                         }
+
+                         // The connection is reset before the next job; waiting first keeps a server that is down from being hammered
+                         std::cerr << "Catalog listener lost its connection: " << PQerrorMessage(conn) << std::endl;
+                         if (::poll(sockets, 1, ListenRetryMillis) > 0)
+                             return nullptr;
+                         return [this]() { listen(); };
+                     });
+}
+
+const SchemaCatalog::Relation *SchemaCatalog::find(const std::string &qualifiedName) const
+{
+    auto it = snapshot->byName.find(qualifiedName);
+    return it != snapshot->byName.end() ? snapshot->relations[it->second].get() : nullptr;
+}
+
+const SchemaCatalog::Relation *SchemaCatalog::find(Oid oid) const
+{
+    auto it = snapshot->byOid.find(oid);
+    return it != snapshot->byOid.end() ? snapshot->relations[it->second].get() : nullptr;
+}
+
+std::string SchemaCatalog::quoteIdentifier(const std::string &name)
+{
+    std::string quoted = "\"";
+    for (char c : name)
+    {
+        quoted += c;
+        if (c == '"')
+        {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string SchemaCatalog::quoteQualifiedName(const std::string &qualifiedName)
+{
+    // Splits at the first dot outside double quotes; parts already quoted are taken as written
+    std::vector<std::string> parts(1);
+    bool inQuotes = false;
+    for (size_t i = 0; i < qualifiedName.size(); i++)
+    {
+        char c = qualifiedName[i];
+        if (c == '"')
+        {
+            if (inQuotes && i + 1 < qualifiedName.size() && qualifiedName[i + 1] == '"')
+            {
+                parts.back() += '"';
+                i++;
+                continue;
+            }
+            inQuotes = !inQuotes;
+            continue;
+        }
+        if (c == '.' && !inQuotes && parts.size() == 1)
+        {
+            parts.emplace_back();
+            continue;
+        }
+        parts.back() += c;
+    }
+
+    std::string quoted;
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        quoted += (i > 0 ? "." : "") + quoteIdentifier(parts[i]);
+    }
+    return quoted;
+}
+
+std::string SchemaCatalog::serialize() const
+{
+    // Only detailed snapshots carry signatures; without them a restored catalog could not be revalidated
+    std::string out;
+    if (!snapshot->detailed)
+        return out;
+
+    BinaryWriter writer(out);
+    writer.value<uint64_t>(snapshot->relations.size());
+    for (const auto &relation : snapshot->relations)
+    {
+        writer.value<Oid>(relation->oid);
+        writer.bytes(relation->schema);
+        writer.bytes(relation->name);
+        writer.value<char>(relation->kind);
+        writer.value<long long>(relation->estimatedRows);
+        writer.bytes(relation->signature);
+        writer.value<uint64_t>(relation->columns.size());
+        for (const auto &column : relation->columns)
+        {
+            writer.bytes(column.name);
+            writer.value<int>(column.number);
+            writer.value<Oid>(column.type);
+            writer.bytes(column.typeName);
+            writer.value<bool>(column.notNull);
+            writer.value<bool>(column.primaryKey);
+        }
+        writer.array(relation->primaryKey);
+        writer.value<uint64_t>(relation->indexes.size());
+        for (const auto &index : relation->indexes)
+        {
+            writer.bytes(index.name);
+            writer.bytes(index.method);
+            writer.array(index.columns);
+            writer.value<uint64_t>(index.opclasses.size());
+            for (const auto &opclass : index.opclasses)
+            {
+                writer.bytes(opclass);
+            }
+            writer.value<bool>(index.unique);
+            writer.value<bool>(index.primary);
+            writer.value<bool>(index.partial);
+        }
+    }
+    return out;
+}
+
+bool SchemaCatalog::restore(std::string_view data)
+{
+    BinaryReader reader(data);
+    uint64_t count = 0;
+    reader.value(count);
+    std::vector<RelationPtr> relations;
+    for (uint64_t i = 0; i < count && reader.ok(); i++)
+    {
+        auto relation = std::make_shared<Relation>();
+        reader.value(relation->oid);
+        reader.bytes(relation->schema);
+        reader.bytes(relation->name);
+        reader.value(relation->kind);
+        reader.value(relation->estimatedRows);
+        reader.bytes(relation->signature);
+        uint64_t columnCount = 0;
+        reader.value(columnCount);
+        for (uint64_t c = 0; c < columnCount && reader.ok(); c++)
+        {
+            Column column;
+            reader.bytes(column.name);
+            reader.value(column.number);
+            reader.value(column.type);
+            reader.bytes(column.typeName);
+            reader.value(column.notNull);
+            reader.value(column.primaryKey);
+            relation->columns.push_back(std::move(column));
+        }
+        reader.array(relation->primaryKey);
+        uint64_t indexCount = 0;
+        reader.value(indexCount);
+        for (uint64_t x = 0; x < indexCount && reader.ok(); x++)
+        {
+            Index index;
+            reader.bytes(index.name);
+            reader.bytes(index.method);
+            reader.array(index.columns);
+            uint64_t opclassCount = 0;
+            reader.value(opclassCount);
+            for (uint64_t o = 0; o < opclassCount && reader.ok(); o++)
+            {
+                std::string opclass;
+                reader.bytes(opclass);
+                index.opclasses.push_back(std::move(opclass));
+            }
+            reader.value(index.unique);
+            reader.value(index.primary);
+            reader.value(index.partial);
+            relation->indexes.push_back(std::move(index));
+        }
+        relation->qualifiedName = relation->schema + "." + relation->name;
+        relation->quotedName = quoteIdentifier(relation->schema) + "." + quoteIdentifier(relation->name);
+        relations.push_back(std::move(relation));
+    }
+
+    // Key and index positions index the column list, and a bad one would be trusted later
+    bool valid = reader.ok() && reader.atEnd() && count > 0;
+    for (size_t i = 0; valid && i < relations.size(); i++)
+    {
+        int columnCount = static_cast<int>(relations[i]->columns.size());
+        for (int position : relations[i]->primaryKey)
+        {
+            valid = valid && position >= 0 && position < columnCount;
+        }
+        for (const auto &index : relations[i]->indexes)
+        {
+            for (int position : index.columns)
+            {
+                valid = valid && position < columnCount;
+            }
+        }
+    }
+    if (!valid)
+        return false;
+
+    apply(buildSnapshot(std::move(relations), true));
+    return true;
+}
+
+void SchemaCatalog::apply(const SnapshotPtr &next)
+{
+    // A failed refresh, or one that found nothing changed, keeps the current snapshot and its version
+    if (!next || next == snapshot)
+        return;
+
+    snapshot = next;
+    snapshotVersion++;
+}
+
+bool SchemaCatalog::fetchRelations(PGconn *conn, StatementCache &statements, bool withSignatures, std::vector<RelationPtr> &relations)
+{
+    // The signature changes whenever DDL rewrites the relation's pg_class row, any of its pg_attribute rows or its set of indexes
+    SqlQuery query;
+    query.sql = "SELECT c.oid, n.nspname, c.relname, c.relkind, c.reltuples::bigint";
+    if (withSignatures)
+    {
+        query.sql += ", c.xmin::text || ':' || COALESCE(a.signature, '') || ':' || COALESCE(x.signature, '')";
+    }
+    query.sql += " FROM pg_class c JOIN pg_namespace n ON n.oid = c.relnamespace";
+    if (withSignatures)
+    {
+        query.sql += " LEFT JOIN (SELECT attrelid, sum(xmin::text::bigint)::text || '/' || count(*) AS signature FROM pg_attribute WHERE attnum > 0 GROUP BY attrelid) a ON a.attrelid = c.oid"
+                     " LEFT JOIN (SELECT indrelid, sum(indexrelid::bigint)::text || '/' || sum(xmin::text::bigint) AS signature FROM pg_index GROUP BY indrelid) x ON x.indrelid = c.oid";
+    }
+    query.sql += std::string(" WHERE ") + RelationFilter;
+
+    PGresult *result = executeCatalogQuery(conn, statements, query);
+    if (!result)
+        return false;
+
+    int count = PQntuples(result);
+    relations.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        auto relation = std::make_shared<Relation>();
+        relation->oid = static_cast<Oid>(std::strtoul(PQgetvalue(result, i, 0), nullptr, 10));
+        relation->schema = PQgetvalue(result, i, 1);
+        relation->name = PQgetvalue(result, i, 2);
+        relation->qualifiedName = relation->schema + "." + relation->name;
+        relation->quotedName = quoteIdentifier(relation->schema) + "." + quoteIdentifier(relation->name);
+        relation->kind = PQgetvalue(result, i, 3)[0];
+        relation->estimatedRows = std::atoll(PQgetvalue(result, i, 4));
+        if (withSignatures)
+        {
+            relation->signature = PQgetvalue(result, i, 5);
+        }
+        relations.push_back(std::move(relation));
+    }
+    PQclear(result);
+    return true;
+}
+
+SchemaCatalog::SnapshotPtr SchemaCatalog::mergeDetails(PGconn *conn, StatementCache &statements, const SnapshotPtr &previous, const std::vector<RelationPtr> &current)
+{
+    // Relations with an unchanged signature are shared with the previous snapshot; the rest get their details loaded again
+    std::vector<RelationPtr> merged;
+    std::vector<std::shared_ptr<Relation>> changed;
+    merged.reserve(current.size());
+    for (const auto &relation : current)
+    {
+        auto it = previous->byOid.find(relation->oid);
+        if (previous->detailed && it != previous->byOid.end() && previous->relations[it->second]->signature == relation->signature)
+        {
+            merged.push_back(previous->relations[it->second]);
+            continue;
+        }
+        auto copy = std::make_shared<Relation>(*relation);
+        changed.push_back(copy);
+        merged.push_back(copy);
+    }
+
+    if (previous->detailed && changed.empty() && merged.size() == previous->relations.size())
+        return previous;
+
+    if (!changed.empty() && !fetchDetails(conn, statements, changed, changed.size() == current.size()))
+        return nullptr;
+
+    return buildSnapshot(std::move(merged), true);
+}
+
+bool SchemaCatalog::fetchDetails(PGconn *conn, StatementCache &statements, const std::vector<std::shared_ptr<Relation>> &targets, bool everything)
+{
+    std::unordered_map<Oid, Relation *> byOid;
+    std::string oids = "{";
+    for (const auto &relation : targets)
+    {
+        byOid[relation->oid] = relation.get();
+        oids += (oids.size() > 1 ? "," : "") + std::to_string(relation->oid);
+    }
+    oids += "}";
+
+    // A full load filters by schema like the relation list does; a refresh names the changed relations
+    auto scope = [&](SqlQuery &query, const std::string &relid)
+    {
+        if (everything)
+            return " JOIN pg_class c ON c.oid = " + relid + " JOIN pg_namespace n ON n.oid = c.relnamespace WHERE " + RelationFilter;
+        return " WHERE " + relid + " = ANY(" + query.bind(oids) + "::oid[])";
+    };
+
+    SqlQuery columnQuery;
+    columnQuery.sql = "SELECT a.attrelid, a.attnum, a.attname, a.atttypid, format_type(a.atttypid, a.atttypmod), a.attnotnull FROM pg_attribute a" + scope(columnQuery, "a.attrelid") +
+                      " AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attrelid, a.attnum";
+    PGresult *result = executeCatalogQuery(conn, statements, columnQuery);
+    if (!result)
+        return false;
+
+    for (int i = 0; i < PQntuples(result); i++)
+    {
+        auto it = byOid.find(static_cast<Oid>(std::strtoul(PQgetvalue(result, i, 0), nullptr, 10)));
+        if (it == byOid.end())
+            continue;
+
+        Column column;
+        column.number = std::atoi(PQgetvalue(result, i, 1));
+        column.name = PQgetvalue(result, i, 2);
+        column.type = static_cast<Oid>(std::strtoul(PQgetvalue(result, i, 3), nullptr, 10));
+        column.typeName = PQgetvalue(result, i, 4);
+        column.notNull = PQgetvalue(result, i, 5)[0] == 't';
+        it->second->columns.push_back(std::move(column));
+    }
+    PQclear(result);
+
+    SqlQuery indexQuery;
+    indexQuery.sql = "SELECT i.indrelid, ic.relname, am.amname, i.indisunique, i.indisprimary, i.indpred IS NOT NULL, i.indnkeyatts, i.indkey::text, "
+                     "(SELECT string_agg(o.opcname, ' ' ORDER BY k.ord) FROM unnest(i.indclass::oid[]) WITH ORDINALITY AS k(opclass, ord) JOIN pg_opclass o ON o.oid = k.opclass) "
+                     "FROM pg_index i JOIN pg_class ic ON ic.oid = i.indexrelid JOIN pg_am am ON am.oid = ic.relam" +
+                     scope(indexQuery, "i.indrelid") + " ORDER BY i.indrelid, i.indisprimary DESC, ic.relname";
+    result = executeCatalogQuery(conn, statements, indexQuery);
+    if (!result)
+        return false;
+
+    for (int i = 0; i < PQntuples(result); i++)
+    {
+        auto it = byOid.find(static_cast<Oid>(std::strtoul(PQgetvalue(result, i, 0), nullptr, 10)));
+        if (it == byOid.end())
+            continue;
+
+        Relation &relation = *it->second;
+        Index index;
+        index.name = PQgetvalue(result, i, 1);
+        index.method = PQgetvalue(result, i, 2);
+        index.unique = PQgetvalue(result, i, 3)[0] == 't';
+        index.primary = PQgetvalue(result, i, 4)[0] == 't';
+        index.partial = PQgetvalue(result, i, 5)[0] == 't';
+        int keyColumns = std::atoi(PQgetvalue(result, i, 6));
+
+        // indkey lists attnums separated by spaces, 0 for an expression; INCLUDE columns follow the key columns
+        std::istringstream attnums(PQgetvalue(result, i, 7));
+        int attnum = 0;
+        while (static_cast<int>(index.columns.size()) < keyColumns && attnums >> attnum)
+        {
+            auto column = std::find_if(relation.columns.begin(), relation.columns.end(), [attnum](const Column &c) { return c.number == attnum; });
+            index.columns.push_back(column != relation.columns.end() ? static_cast<int>(column - relation.columns.begin()) : -1);
+        }
+        std::istringstream opclasses(PQgetvalue(result, i, 8));
+        std::string opclass;
+        while (opclasses >> opclass)
+        {
+            index.opclasses.push_back(opclass);
+        }
+
+        if (index.primary)
+        {
+            for (int col : index.columns)
+            {
+                if (col < 0)
+                    continue;
+                relation.primaryKey.push_back(col);
+                relation.columns[col].primaryKey = true;
+                relation.columns[col].notNull = true;
+            }
+        }
+        relation.indexes.push_back(std::move(index));
+    }
+    PQclear(result);
+    return true;
+}
+
+SchemaCatalog::SnapshotPtr SchemaCatalog::buildSnapshot(std::vector<RelationPtr> relations, bool detailed)
+{
+    // public comes first, as it is where most browsing happens; other schemas follow by name
+    std::sort(relations.begin(), relations.end(),
+              [](const RelationPtr &a, const RelationPtr &b)
+              {
+                  bool aPublic = a->schema == "public";
+                  bool bPublic = b->schema == "public";
+                  if (aPublic != bPublic)
+                      return aPublic;
+                  if (a->schema != b->schema)
+                      return a->schema < b->schema;
+                  return a->name < b->name;
+              });
+
+    auto next = std::make_shared<Snapshot>();
+    next->detailed = detailed;
+    next->byOid.reserve(relations.size());
+    next->byName.reserve(relations.size());
+    for (int i = 0; i < static_cast<int>(relations.size()); i++)
+    {
+        const Relation &relation = *relations[i];
+        if (next->schemas.empty() || next->schemas.back().name != relation.schema)
+        {
+            next->schemas.push_back({relation.schema, {}});
+        }
+        next->schemas.back().relations.push_back(i);
+        next->byOid[relation.oid] = i;
+        next->byName[relation.qualifiedName] = i;
+    }
+    next->relations = std::move(relations);
+    return next;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+// Standard library includes
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+// Project includes
+#include "ConnectionPool.h"
+
+// Schemas, tables, views and their columns, types, primary keys and indexes,
+// read straight from pg_catalog. Relation names arrive first in one query so the
+// table list can be shown at once; columns and indexes follow in two more
+// queries on a background connection.
+//
+// Each load produces an immutable snapshot indexed by oid and qualified name.
+// A refresh lists relations again with a signature per relation (the xmin of
+// its pg_class row, pg_attribute rows and pg_index rows) and reloads columns and
+// indexes only for relations whose signature changed; the others are shared with
+// the previous snapshot. Refreshes run on request and whenever a notification
+// arrives on NotifyChannel, e.g. from a DDL event trigger. Notifications are
+// received on a connection of their own whose worker sleeps on the socket, so
+// an idle catalog costs no round trips and no frames.
+//
+// A detailed snapshot can be saved to the disk cache with its signatures; a
+// restored one is shown at once and revalidated by the same refresh.
+class SchemaCatalog
+{
+  public:
+    struct Column
+    {
+        std::string name;
+        int number = 0; // attnum
+        Oid type = 0;
+        std::string typeName;
+        bool notNull = false;
+        bool primaryKey = false;
+    };
+
+    struct Index
+    {
+        std::string name;
+        std::string method;                 // btree, gin, ...
+        std::vector<int> columns;           // Column positions; -1 for expressions
+        std::vector<std::string> opclasses; // One per indexed column
+        bool unique = false;
+        bool primary = false;
+        bool partial = false;
+    };
+
+    struct Relation
+    {
+        Oid oid = 0;
+        std::string schema;
+        std::string name;
+        std::string qualifiedName; // schema.name, as shown in the UI
+        std::string quotedName;    // Quoted and schema-qualified, for SQL
+        char kind = 'r';           // pg_class.relkind
+        long long estimatedRows = -1;
+        std::string signature;
+        std::vector<Column> columns;
+        std::vector<int> primaryKey;
+        std::vector<Index> indexes;
+    };
+
+    struct Schema
+    {
+        std::string name;
+        std::vector<int> relations; // Relation indices, ordered by name
+    };
+
+    static constexpr const char *NotifyChannel = "dbe_catalog";
+
+    // Constructor/Destructor
+    SchemaCatalog(ConnectionPool *pool);
+    ~SchemaCatalog();
+
+    // Main public interface
+    void load();
+    void refresh();
+    void poll();
+    bool isLoading() const { return loading; }
+    bool isRefreshing() const { return refreshing; }
+    bool hasDetails() const { return snapshot->detailed; }
+
+    // Lookup; references stay valid until the next snapshot is applied
+    const std::vector<Schema> &schemas() const { return snapshot->schemas; }
+    int relationCount() const { return static_cast<int>(snapshot->relations.size()); }
+    const Relation &relation(int index) const { return *snapshot->relations[index]; }
+    const Relation *find(const std::string &qualifiedName) const;
+    const Relation *find(Oid oid) const;
+    uint64_t version() const { return snapshotVersion; }
+
+    // Statistics
+    double namesMillis() const { return namesTime; }
+    double loadMillis() const { return loadTime; }
+
+    static std::string quoteIdentifier(const std::string &name);
+    static std::string quoteQualifiedName(const std::string &qualifiedName);
+
+    // Disk cache image; restore() replaces the snapshot, and refresh() then reloads whatever changed since
+    std::string serialize() const;
+    bool restore(std::string_view data);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using RelationPtr = std::shared_ptr<const Relation>;
+
+    struct Snapshot
+    {
+        std::vector<RelationPtr> relations; // Ordered by schema, then name
+        std::vector<Schema> schemas;
+        std::unordered_map<Oid, int> byOid;
+        std::unordered_map<std::string, int> byName;
+        bool detailed = false;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    ConnectionPool *pool;
+    SnapshotPtr snapshot;
+    uint64_t snapshotVersion = 0;
+    int loadGeneration = 0;
+
+    // Load and refresh state; a refresh requested while one runs is queued behind it
+    bool loading = false;
+    bool refreshing = false;
+    bool refreshQueued = false;
+    Clock::time_point loadStart;
+    double namesTime = 0.0;
+    double loadTime = 0.0;
+
+    // Notification listener; its job waits on the socket and on stopPipe, which the destructor writes to.
+    // A broken connection ends the job, and the next one reconnects and listens again.
+    std::unique_ptr<QueryExecutor> listener;
+    int stopPipe[2] = {-1, -1};
+    void listen();
+
+    void apply(const SnapshotPtr &next);
+    static bool fetchRelations(PGconn *conn, StatementCache &statements, bool withSignatures, std::vector<RelationPtr> &relations);
+    static SnapshotPtr mergeDetails(PGconn *conn, StatementCache &statements, const SnapshotPtr &previous, const std::vector<RelationPtr> &current);
+    static bool fetchDetails(PGconn *conn, StatementCache &statements, const std::vector<std::shared_ptr<Relation>> &targets, bool everything);
+    static SnapshotPtr buildSnapshot(std::vector<RelationPtr> relations, bool detailed);
+};
@@ -0,0 +1,157 @@
+#include "StatementCache.h"
+#include "QueryExecutor.h"
+#include "Trace.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <vector>
+
+StatementCache::StatementCache(size_t capacity) : capacity(capacity) {}
+
+PGresult *StatementCache::execute(PGconn *conn, const SqlQuery &query)
+{
+    std::vector<const char *> values;
+    values.reserve(query.params.size());
+    for (const auto &param : query.params)
+    {
+        values.push_back(param.c_str());
+    }
+
+    for (int attempt = 0;; attempt++)
+    {
+        const char *name = prepare(conn, query);
+        if (!name)
+        {
+            return PQmakeEmptyPGresult(conn, PGRES_FATAL_ERROR);
+        }
+
+        PGresult *result = executePrepared(conn, name, values, query);
+
+        // Statements vanish when the server discards session state; prepare again once
+        const char *state = PQresultErrorField(result, PG_DIAG_SQLSTATE);
+        if (attempt == 0 && state && strcmp(state, "26000") == 0)
+        {
+            PQclear(result);
+            forget(shapeKey(query));
+            continue;
+        }
+        return result;
+    }
+}
+
+const char *StatementCache::prepare(PGconn *conn, const SqlQuery &query)
+{
+    std::string key = shapeKey(query);
+    auto it = statements.find(key);
+    if (it != statements.end())
+    {
+        hits++;
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return it->second.name.c_str();
+    }
+
+    misses++;
+    evict(conn);
+
+    std::string name = "dbe_" + std::to_string(++nextId);
+    const Oid *types = query.paramTypes.empty() ? nullptr : query.paramTypes.data();
+    auto start = std::chrono::steady_clock::now();
+    PGresult *result = PQprepare(conn, name.c_str(), query.sql.c_str(), static_cast<int>(query.paramTypes.size()), types);
+    prepareMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    bool prepared = PQresultStatus(result) == PGRES_COMMAND_OK;
+    if (!prepared)
+    {
+        std::cerr << "Prepare failed: " << PQerrorMessage(conn) << std::endl;
+    }
+    PQclear(result);
+    if (!prepared)
+        return nullptr;
+
+    lru.push_front(key);
+    Statement &statement = statements[key];
+    statement = {name, lru.begin()};
+    statementCount = statements.size();
+    return statement.name.c_str();
+}
+
+void StatementCache::reset()
+{
+    // The server side is already gone (e.g. after a reconnect); only local state is dropped
+    lru.clear();
+    statements.clear();
+    statementCount = 0;
+}
+
+PGresult *StatementCache::executePrepared(PGconn *conn, const char *name, const std::vector<const char *> &values, const SqlQuery &query)
+{
+    // PQexecPrepared split into its phases so each can be traced: sending, waiting for
+    // the first reply bytes (server time plus one round trip) and reading the rest
+    uint64_t start = Trace::now();
+    if (!PQsendQueryPrepared(conn, name, static_cast<int>(values.size()), values.data(), nullptr, nullptr, query.resultFormat))
+    {
+        return PQmakeEmptyPGresult(conn, PGRES_FATAL_ERROR);
+    }
+    uint64_t sent = Trace::now();
+    Trace::record("send", "query", start, sent, query.sql);
+
+    uint64_t firstReply = 0;
+    while (PQisBusy(conn))
+    {
+        pollfd socket = {PQsocket(conn), POLLIN, 0};
+        poll(&socket, 1, 10);
+        if (firstReply == 0 && (socket.revents & POLLIN))
+        {
+            firstReply = Trace::now();
+        }
+        if (!PQconsumeInput(conn))
+            break;
+    }
+    uint64_t received = Trace::now();
+    firstReply = firstReply ? firstReply : received;
+    Trace::record("server", "query", sent, firstReply, query.sql);
+    Trace::record("transfer", "query", firstReply, received, query.sql);
+
+    // Like PQexec, the last result is returned
+    PGresult *result = nullptr;
+    while (PGresult *next = PQgetResult(conn))
+    {
+        PQclear(result);
+        result = next;
+    }
+    return result ? result : PQmakeEmptyPGresult(conn, PGRES_FATAL_ERROR);
+}
+
+std::string StatementCache::shapeKey(const SqlQuery &query)
+{
+    std::string key = query.sql;
+    key += '\0';
+    for (Oid type : query.paramTypes)
+    {
+        key += std::to_string(type) + ',';
+    }
+    return key;
+}
+
+void StatementCache::forget(const std::string &key)
+{
+    auto it = statements.find(key);
+    if (it == statements.end())
+        return;
+
+    lru.erase(it->second.lru);
+    statements.erase(it);
+    statementCount = statements.size();
+}
+
+void StatementCache::evict(PGconn *conn)
+{
+    while (statements.size() >= capacity && !lru.empty())
+    {
+        std::string key = lru.back();
+        std::string sql = "DEALLOCATE \"" + statements[key].name + "\"";
+        PQclear(PQexec(conn, sql.c_str()));
+        forget(key);
+    }
+}
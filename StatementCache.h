@@ -0,0 +1,63 @@
+#pragma once
+
+// Standard library includes
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// External library includes
+#include <libpq-fe.h>
+
+struct SqlQuery;
+
+// Prepared statements of one connection, keyed by query shape (the parameterized
+// SQL text plus parameter types). The first execution of a shape prepares it,
+// later ones execute it directly, traced as send, server and transfer spans.
+// Least recently used statements are deallocated once the cache is full. Only
+// the connection's worker thread may execute through it; the statistics can be
+// read from any thread.
+class StatementCache
+{
+  public:
+    // Constructor
+    StatementCache(size_t capacity = 256);
+
+    // Main public interface; results follow PQexecParams conventions
+    PGresult *execute(PGconn *conn, const SqlQuery &query);
+    const char *prepare(PGconn *conn, const SqlQuery &query);
+    void reset();
+
+    // Statements prepared in a row stay allocated as long as they number no more than maxSize()
+    size_t maxSize() const { return capacity; }
+    static std::string shapeKey(const SqlQuery &query);
+
+    // Statistics
+    size_t size() const { return statementCount; }
+    uint64_t hitCount() const { return hits; }
+    uint64_t missCount() const { return misses; }
+    double prepareMillis() const { return prepareMicros / 1000.0; }
+
+  private:
+    struct Statement
+    {
+        std::string name;
+        std::list<std::string>::iterator lru;
+    };
+
+    size_t capacity;
+    uint64_t nextId = 0;
+    std::list<std::string> lru; // Most recently used shape first
+    std::unordered_map<std::string, Statement> statements;
+
+    std::atomic<size_t> statementCount{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> prepareMicros{0};
+
+    static PGresult *executePrepared(PGconn *conn, const char *name, const std::vector<const char *> &values, const SqlQuery &query);
+    void forget(const std::string &key);
+    void evict(PGconn *conn);
+};
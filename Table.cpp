@@ -1,14 +1,65 @@
 #include "Table.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <poll.h>
+#include <unordered_set>
 
-Table::Table(PGconn *conn) : conn(conn) {}
+namespace
+{
+// Hidden columns fetched after the visible ones to identify rows for updates
+constexpr const char *RowVersionColumn = "dbe_xmin";
+constexpr const char *CtidColumn = "dbe_ctid";
+
+// Hidden per-column octet_length of previewed values, followed by the column's position
+constexpr const char *SizeColumnPrefix = "dbe_size_";
+
+// Page queries alias the relation, so ORDER BY names its columns rather than the previews and text casts
+// projected under the same names
+constexpr const char *RelationAlias = "r";
+
+std::string formatBytes(long long bytes)
+{
+    char text[32];
+    if (bytes >= (1 << 20))
+        snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+    else if (bytes >= (1 << 10))
+        snprintf(text, sizeof(text), "%.1f KB", bytes / 1024.0);
+    else
+        snprintf(text, sizeof(text), "%lld bytes", bytes);
+    return text;
+}
+} // namespace
+
+Table::Table(ConnectionPool *pool, PageCache *pageCache, const SchemaCatalog *catalog) : pool(pool), executor(pool ? pool->foreground() : nullptr), catalog(catalog), pageCache(pageCache), exporter(pool), importer(pool) {}
 
-Table::~Table() {}
+Table::~Table()
+{
+    stopStream();
+    if (pool)
+    {
+        pool->discard(this);
+        pool->discard(loadOwner());
+        pool->discard(prefetchOwner());
+        pool->discard(countOwner());
+    }
+}
 
 void Table::render()
 {
+    Trace::Scope trace("table", "ui", currentTable);
+    if (catalog && catalog->version() != catalogVersion && !currentTable.empty())
+    {
+        resolveRelation();
+    }
     if (columns.empty())
     {
+        if (isLoading())
+        {
+            ImGui::TextDisabled("Loading %s...", currentTable.c_str());
+        }
         return;
     }
 
@@ -19,6 +70,7 @@ void Table::render()
     if (ImGui::BeginTable("##TableData", columns.size(), flags, ImVec2(0, tableHeight)))
     {
         renderTableHeaders();
+        handleSorting();
         renderTableRows();
         ImGui::EndTable();
     }
@@ -26,28 +78,86 @@ void Table::render()
     renderPagination();
 }
 
-void Table::loadTableData(const std::string &tableName, int offset)
+bool Table::isLoading() const { return !awaitedKey.empty() || (executor && (executor->isBusy(loadOwner()) || executor->isBusy(this))); }
+
+bool Table::isWorking() const { return isLoading() || streaming || exporter.isRunning() || importer.isRunning(); }
+
+void Table::cancelQueries()
 {
-    if (!conn)
-        return;
+    // What is on screen stays; the page load, stream and count in flight are stopped on the server
+    ++loadGeneration;
+    stopStream();
+    awaitedKey.clear();
+    executor->cancel(loadOwner());
+    pool->cancel(countOwner());
+    countingRows = false;
+}
 
-    initializeTable(tableName, offset);
+size_t Table::memoryBytes() const
+{
+    size_t bytes = rows.memoryBytes() + (rowOrder.capacity() + displayRows.capacity()) * sizeof(int);
+    for (const auto &filter : compiledFilters)
+    {
+        bytes += filter.matches.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+bool Table::releaseRows()
+{
+    // Only a settled view lets go: nothing loading or streaming, and no edit that refers to row indices
+    if (rowsReleased || rows.rowCount() == 0 || isLoading() || streaming || isEditing || committingEdits || !pendingRows.empty())
+        return false;
+
+    // Swapping with empty containers returns their capacity, which clear() would keep
+    rows = ResultStore();
+    std::vector<int>().swap(rowOrder);
+    std::vector<int>().swap(displayRows);
+    for (auto &filter : compiledFilters)
+    {
+        std::vector<uint64_t>().swap(filter.matches);
+        filter.coveredRows = 0;
+    }
+    rowsVersion++;
+    displayRowsDirty = true;
+    rowsReleased = true;
+    return true;
+}
 
-    std::string dataQuery = columns.empty() ? buildInitialQuery(offset) : buildFilteredQuery();
+void Table::restoreRows()
+{
+    if (rowsReleased)
+    {
+        loadTableData(currentTable, currentOffset);
+    }
+}
 
-    PGresult *dataRes = nullptr;
-    executeQuery(dataQuery, dataRes);
-    if (!dataRes)
+void Table::loadTableData(const std::string &tableName, int offset)
+{
+    if (!executor)
         return;
 
+    initializeTable(tableName, offset);
     if (columns.empty())
     {
-        loadColumns(dataRes);
+        requestInitialData();
+    }
+    else
+    {
+        requestView();
     }
+}
 
-    loadRows(dataRes);
-    PQclear(dataRes);
-    checkForMoreRows();
+void Table::requestView()
+{
+    if (streamRows)
+    {
+        requestStream(buildStreamQuery());
+    }
+    else
+    {
+        requestData(buildFilteredQuery());
+    }
 }
 
 void Table::initializeTable(const std::string &tableName, int offset)
@@ -55,112 +165,468 @@ void Table::initializeTable(const std::string &tableName, int offset)
     if (currentTable != tableName)
     {
         currentTable = tableName;
-        columns.clear();
+        resetColumns();
+
+        // Nothing queued for the previous table is worth finishing
+        pool->cancel(prefetchOwner());
+        pool->cancel(countOwner());
+        prefetching.clear();
+        countingRows = false;
+
+        // Names the catalog does not know (or a catalog still loading its details) fall back to probing the table
+        relationName = SchemaCatalog::quoteQualifiedName(tableName);
+        catalogVersion = catalog ? catalog->version() : 0;
+        const SchemaCatalog::Relation *relation = catalog ? catalog->find(tableName) : nullptr;
+        if (relation)
+        {
+            relationName = relation->quotedName;
+            if (!relation->columns.empty())
+            {
+                loadCatalogColumns(*relation);
+            }
+        }
     }
     currentOffset = offset;
+}
+
+void Table::resetColumns()
+{
+    columns.clear();
+    columnTypes.clear();
     rows.clear();
+    rowOrder.clear();
+    displayRows.clear();
+    primaryKeyColumns.clear();
+    columnNotNull.clear();
+    rowKeyColumns.clear();
+    fetchRowVersion = false;
+    identifyByCtid = false;
+    sortColumn = 0;
+    resetPageCursors();
+    cancelEdit();
+}
+
+void Table::resolveRelation()
+{
+    // Row indices of edits refer to the columns as they are; the catalog is checked again once they are done
+    if (committingEdits || !pendingRows.empty())
+        return;
+
+    catalogVersion = catalog->version();
+    const SchemaCatalog::Relation *relation = catalog->find(currentTable);
+    if (!relation)
+        return;
+
+    bool renamed = relation->quotedName != relationName;
+    bool altered = !relation->columns.empty() && relation->columns.size() != columns.size();
+    for (size_t i = 0; !altered && i < columns.size() && !relation->columns.empty(); i++)
+    {
+        // Names only: a page reports a domain column by its base type, which the catalog does not
+        altered = relation->columns[i].name != columns[i];
+    }
+    if (!renamed && !altered)
+        return;
+
+    relationName = relation->quotedName;
+    if (altered)
+    {
+        resetColumns();
+        loadCatalogColumns(*relation);
+    }
+    loadTableData(currentTable, altered ? 0 : currentOffset);
+}
+
+int Table::beginLoad()
+{
+    // Every new request supersedes running streams, awaited prefetches and older loads; a superseded
+    // query still queued is dropped and one already running is cancelled on the server
+    stopStream();
+    awaitedKey.clear();
+    executor->cancel(loadOwner());
+    rowsReleased = false;
+    requestedFilters = columnFilters;
+    return ++loadGeneration;
+}
+
+void Table::requestInitialData()
+{
+    int generation = beginLoad();
+    std::string relation = relationName;
+    int offset = currentOffset;
+    int limit = rowsPerPage;
+    StatementCache *statements = &executor->statements();
+
+    executor->submit(loadOwner(),
+                     [this, generation, relation, offset, limit, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         // Key columns are needed up front so the first page is ordered the same way later keyset pages are
+                         ResultPtr keysResult = fetchColumnKeys(conn, *statements, relation);
+                         bool moreRows = false;
+                         PagePtr page = fetchPage(conn, *statements, buildInitialQuery(relation, keysResult.get(), offset, limit), limit, moreRows);
+                         return [this, generation, page, keysResult, moreRows]()
+                         {
+                             if (generation == loadGeneration)
+                             {
+                                 applyData(page, keysResult, moreRows);
+                                 prefetchNeighbors();
+                             }
+                         };
+                     });
+}
+
+void Table::requestData(const SqlQuery &query)
+{
+    int generation = beginLoad();
+    std::string key = pageKey(query);
+
+    PageCache::Entry cached;
+    if (pageCache && pageCache->find(key, cached))
+    {
+        applyData(std::make_shared<ResultStore>(*cached.page), nullptr, cached.moreRows);
+        prefetchNeighbors();
+        return;
+    }
+    auto inFlight = prefetching.find(key);
+    if (inFlight != prefetching.end())
+    {
+        // The prefetch completion applies the page when it lands
+        *inFlight->second = false;
+        awaitedKey = key;
+        return;
+    }
+
+    // The previous page stays on screen until the worker hands back the new one
+    int limit = rowsPerPage;
+    uint64_t cacheGeneration = pageCache ? pageCache->generation() : 0;
+    std::string relation = relationName;
+    StatementCache *statements = &executor->statements();
+
+    executor->submit(loadOwner(),
+                     [this, generation, relation, key, query, limit, cacheGeneration, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         bool moreRows = false;
+                         PagePtr page = fetchPage(conn, *statements, query, limit, moreRows);
+                         return [this, generation, relation, key, page, moreRows, cacheGeneration]()
+                         {
+                             cachePage(relation, key, page, moreRows, cacheGeneration);
+                             if (generation == loadGeneration)
+                             {
+                                 applyData(page, nullptr, moreRows);
+                                 prefetchNeighbors();
+                             }
+                         };
+                     });
+}
+
+Table::PagePtr Table::fetchPage(PGconn *conn, StatementCache &statements, const SqlQuery &query, int limit, bool &moreRows)
+{
+    ResultPtr result = executeQuery(conn, statements, query);
+    if (!result)
+        return nullptr;
+
+    PagePtr page = loadRows(result.get(), limit);
+    // Page queries ask for one row more than they show; its presence is the "has more" signal
+    moreRows = PQntuples(result.get()) > limit;
+    return page;
+}
+
+std::string Table::pageKey(const SqlQuery &query) const
+{
+    // The SQL text encodes table, filtered columns, sort column and direction; params carry filter text, cursor and offset
+    std::string key = currentTable + '\n' + std::to_string(query.resultFormat) + query.sql;
+    for (const auto &param : query.params)
+    {
+        key += '\x1f' + param;
+    }
+    return key;
+}
+
+void Table::cachePage(const std::string &relation, const std::string &key, const PagePtr &page, bool moreRows, uint64_t cacheGeneration)
+{
+    if (pageCache && page)
+    {
+        pageCache->insert(relation, key, {std::make_shared<ResultStore>(*page), moreRows}, cacheGeneration);
+    }
+}
+
+void Table::prefetchNeighbors()
+{
+    if (!pageCache || streamRows)
+        return;
+
+    std::vector<int> offsets;
+    if (hasMoreRows)
+    {
+        offsets.push_back(currentOffset + rowsPerPage);
+    }
+    if (currentOffset > 0)
+    {
+        offsets.push_back(std::max(0, currentOffset - rowsPerPage));
+    }
+
+    // Prefetches for pages that are no longer next to this one are skipped unless they have already started
+    std::set<std::string> wanted;
+    for (int offset : offsets)
+    {
+        wanted.insert(pageKey(buildPageQuery(offset)));
+    }
+    for (auto &[key, dropped] : prefetching)
+    {
+        *dropped = !wanted.count(key);
+    }
+
+    for (int offset : offsets)
+    {
+        prefetchPage(offset);
+    }
+}
+
+void Table::prefetchPage(int offset)
+{
+    SqlQuery query = buildPageQuery(offset);
+    std::string key = pageKey(query);
+    if (pageCache->contains(key) || prefetching.count(key))
+        return;
+
+    auto dropped = std::make_shared<std::atomic<bool>>(false);
+    prefetching[key] = dropped;
+    int limit = rowsPerPage;
+    uint64_t cacheGeneration = pageCache->generation();
+    std::string relation = relationName;
+    QueryExecutor *background = pool->background();
+    StatementCache *statements = &background->statements();
+
+    background->submit(prefetchOwner(),
+                     [this, relation, key, query, limit, cacheGeneration, statements, dropped](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         bool moreRows = false;
+                         PagePtr page = *dropped ? nullptr : fetchPage(conn, *statements, query, limit, moreRows);
+                         return [this, relation, key, page, moreRows, cacheGeneration]()
+                         {
+                             prefetching.erase(key);
+                             cachePage(relation, key, page, moreRows, cacheGeneration);
+                             if (key != awaitedKey)
+                                 return;
+
+                             awaitedKey.clear();
+                             if (page)
+                             {
+                                 applyData(page, nullptr, moreRows);
+                                 prefetchNeighbors();
+                             }
+                             else
+                             {
+                                 requestView();
+                             }
+                         };
+                     });
+}
+
+void Table::applyData(const PagePtr &page, const ResultPtr &keysResult, bool moreRows)
+{
+    if (!page)
+        return;
+
+    // Row indices of an open editor refer to the page being replaced
+    cancelEdit();
+
+    if (columns.empty())
+    {
+        // Hidden columns follow the table's own; the key lookup says how many those are
+        loadColumns(*page, keysResult ? std::min(PQntuples(keysResult.get()), page->columnCount()) : page->columnCount());
+    }
+    if (keysResult)
+    {
+        loadColumnKeys(keysResult.get());
+    }
+
+    rows = std::move(*page);
+    rowsFilters = requestedFilters;
+    findSizeColumns();
+    pageVersion++;
+    rowsVersion++;
+    rowOrder.resize(rows.rowCount());
+    for (int i = 0; i < rows.rowCount(); i++)
+    {
+        rowOrder[i] = i;
+    }
+    rowOrderDirty = !sortKeys.empty();
+    displayRowsDirty = true;
+    recordPageCursor();
+    hasMoreRows = moreRows;
+    requestRowEstimate();
 }
 
-void Table::executeQuery(const std::string &query, PGresult *&result)
+Table::ResultPtr Table::executeQuery(PGconn *conn, StatementCache &statements, const SqlQuery &query)
 {
-    std::cout << "Executing query: " << query << std::endl;
-    result = PQexec(conn, query.c_str());
+    // Values travel as bound parameters of a cached prepared statement, never as SQL text
+    PGresult *result = statements.execute(conn, query);
 
     if (PQresultStatus(result) != PGRES_TUPLES_OK)
     {
         std::cerr << "Data query failed: " << PQerrorMessage(conn) << std::endl;
         PQclear(result);
-        result = nullptr;
+        return nullptr;
     }
+    return ResultPtr(result, PQclear);
 }
 
-void Table::loadColumns(PGresult *result)
+void Table::loadColumns(const ResultStore &page, int count)
 {
-    int numDataCols = PQnfields(result);
+    int numDataCols = count;
     columns.reserve(numDataCols);
+    columnTypes.reserve(numDataCols);
 
     for (int i = 0; i < numDataCols; i++)
     {
-        columns.push_back(PQfname(result, i));
-        std::cout << "Column " << i << ": " << columns.back() << std::endl;
+        columns.push_back(page.columnName(i));
+        columnTypes.push_back(page.columnType(i));
+    }
+    initializeFilters();
+}
+
+void Table::loadCatalogColumns(const SchemaCatalog::Relation &relation)
+{
+    for (int i = 0; i < static_cast<int>(relation.columns.size()); i++)
+    {
+        const SchemaCatalog::Column &column = relation.columns[i];
+        columns.push_back(column.name);
+        columnTypes.push_back(column.type);
+        columnNotNull.push_back(column.notNull);
     }
+    primaryKeyColumns = relation.primaryKey;
+    chooseRowIdentity();
+    initializeFilters();
+}
 
+void Table::initializeFilters()
+{
     // Initialize filters after loading columns
     columnFilters.clear();
     columnFilters.resize(columns.size(), "");
+    updateHeaderLabels();
 }
 
-void Table::loadRows(PGresult *result)
+Table::PagePtr Table::loadRows(const PGresult *result, int limit)
 {
-    int numRows = PQntuples(result);
-    std::cout << "Found " << numRows << " rows" << std::endl;
+    // Decoded on the worker; page queries fetch one extra row to learn whether another page exists
+    Trace::Scope trace("decode", "query");
+    auto page = std::make_shared<ResultStore>();
+    page->assign(result, limit);
+    return page;
+}
 
-    rows.reserve(numRows);
-    for (int i = 0; i < numRows; i++)
+SqlQuery Table::buildInitialQuery(const std::string &relation, const PGresult *columnKeys, int offset, int limit)
+{
+    // The key lookup lists every column with its type, so wide columns are previewed from the first page on;
+    // the first column and the keys order the page and are fetched whole
+    std::string list;
+    std::string sizes;
+    std::string order = " ORDER BY 1";
+    int count = columnKeys ? PQntuples(columnKeys) : 0;
+    for (int i = 0; i < count; i++)
     {
-        std::vector<std::string> row;
-        row.reserve(columns.size());
-
-        for (int j = 0; j < columns.size(); j++)
+        std::string name = SchemaCatalog::quoteIdentifier(PQgetvalue(columnKeys, i, 0));
+        Oid type = static_cast<Oid>(std::strtoul(PQgetvalue(columnKeys, i, 3), nullptr, 10));
+        bool key = std::string(PQgetvalue(columnKeys, i, 2)) == "t";
+        if (key)
         {
-            if (PQgetisnull(result, i, j))
-            {
-                row.push_back("NULL");
-            }
-            else
-            {
-                row.push_back(PQgetvalue(result, i, j));
-            }
+            order += ", " + name;
+        }
+        if (i > 0 && !key && previewsType(type))
+        {
+            list += ", " + previewExpression(name);
+            sizes += ", " + sizeExpression(name, type, i);
+        }
+        else
+        {
+            list += (i > 0 ? ", " : "") + name;
         }
-        rows.push_back(std::move(row));
     }
-}
 
-std::string Table::buildInitialQuery(int offset) const { return "SELECT * FROM \"" + currentTable + "\" ORDER BY 1 LIMIT " + std::to_string(rowsPerPage) + " OFFSET " + std::to_string(offset); }
+    SqlQuery query;
+    query.sql = "SELECT " + (count > 0 ? list + sizes : "*") + " FROM " + relation + order;
+    query.sql += " LIMIT " + query.bind(std::to_string(limit + 1));
+    query.sql += " OFFSET " + query.bind(std::to_string(offset));
+    return query;
+}
 
 void Table::renderTableRows()
 {
-    for (int row = 0; row < rows.size(); row++)
+    if (displayRowsDirty)
     {
-        if (!shouldShowRow(rows[row]))
-        {
-            continue;
-        }
+        rebuildDisplayRows();
+    }
 
-        ImGui::TableNextRow();
-        for (int col = 0; col < columns.size(); col++)
+    // Only rows inside the scroll window are submitted, so frame cost does not grow with the page
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(displayRows.size()));
+    while (clipper.Step())
+    {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
         {
-            ImGui::TableSetColumnIndex(col);
-            if (isEditing && row == editRow && col == editCol)
+            int row = displayRows[i];
+            ImGui::TableNextRow();
+            ImGui::PushID(row);
+            for (int col = 0; col < columns.size(); col++)
             {
-                renderTableCellEdit(row, col);
-            }
-            else
-            {
-                renderTableCell(row, col);
+                // Skip columns scrolled out of view horizontally
+                if (!ImGui::TableSetColumnIndex(col))
+                    continue;
+
+                ImGui::PushID(col);
+                if (isEditing && row == editRow && col == editCol)
+                {
+                    renderTableCellEdit(row, col);
+                }
+                else
+                {
+                    renderTableCell(row, col);
+                }
+                ImGui::PopID();
             }
+            ImGui::PopID();
+        }
+    }
+}
+
+void Table::rebuildDisplayRows()
+{
+    Trace::Scope trace("filter", "ui");
+    updateFilterMatches();
+    displayRows.clear();
+    displayRows.reserve(rowOrder.size());
+    for (int row : rowOrder)
+    {
+        if (shouldShowRow(row))
+        {
+            displayRows.push_back(row);
         }
     }
+    displayRowsDirty = false;
 }
 
 void Table::renderTableCell(int row, int col)
 {
-    std::string cellId = "##" + currentTable + "_Cell_" + std::to_string(row) + "_" + std::to_string(col) + "_";
+    // First-line spans of text cells are precomputed by the store; typed cells are formatted only while visible
+    char formatted[128];
+    std::string_view firstLine = rows.displayText(row, col, formatted, sizeof(formatted));
 
-    // Extract first line for display
-    std::string value = rows[row][col];
-    std::string firstLine = value;
-    size_t newlinePos = value.find('\n');
-    if (newlinePos != std::string::npos)
+    // Uncommitted edits show their new value on a highlighted background
+    const std::string *pending = findPendingValue(row, col);
+    if (pending)
     {
-        firstLine = value.substr(0, newlinePos);
+        const PendingRow &pendingRow = pendingRows.find(std::make_pair(pageVersion, row))->second;
+        ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, pendingRow.error.empty() ? IM_COL32(150, 110, 20, 110) : IM_COL32(170, 40, 40, 130));
+        firstLine = std::string_view(*pending);
+        firstLine = firstLine.substr(0, firstLine.find('\n'));
     }
 
     ImVec2 pos = ImGui::GetCursorPos();
 
     // Render selectable
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
-    if (ImGui::Selectable(cellId.c_str(), false, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(ImGui::GetColumnWidth(), ImGui::GetTextLineHeight())))
+    if (ImGui::Selectable("##Cell", false, ImGuiSelectableFlags_AllowDoubleClick, ImVec2(ImGui::GetColumnWidth(), ImGui::GetTextLineHeight())))
     {
         if (ImGui::IsMouseDoubleClicked(0))
         {
@@ -169,14 +635,47 @@ void Table::renderTableCell(int row, int col)
     }
     ImGui::PopStyleVar();
 
+    if (pending && ImGui::IsItemHovered())
+    {
+        const std::string &error = pendingRows.find(std::make_pair(pageVersion, row))->second.error;
+        ImGui::SetTooltip("%s", error.empty() ? "Pending change; not committed yet" : error.c_str());
+    }
+    else if (!pending && ImGui::IsItemHovered() && isTruncated(row, col))
+    {
+        std::string size = formatBytes(valueSize(row, col));
+        if (canLoadFullValue(row))
+        {
+            ImGui::SetTooltip("Preview of a %s value; double-click to load and edit all of it", size.c_str());
+        }
+        else
+        {
+            ImGui::SetTooltip("Preview of a %s value; the table has no key to load the rest by", size.c_str());
+        }
+    }
+
     // Render text content
     ImGui::SetCursorPos(pos);
-    ImGui::TextUnformatted(firstLine.c_str());
+    if (rows.isNull(row, col) && !pending)
+    {
+        ImGui::TextDisabled("NULL");
+    }
+    else
+    {
+        ImGui::TextUnformatted(firstLine.data(), firstLine.data() + firstLine.size());
+    }
 }
 
 void Table::renderTableCellEdit(int row, int col)
 {
-    std::string editId = "##" + currentTable + "_Edit_" + std::to_string(row) + "_" + std::to_string(col);
+    if (loadingFullValue)
+    {
+        ImGui::TextDisabled("Loading %s...", formatBytes(valueSize(row, col)).c_str());
+        if (ImGui::IsKeyPressed(ImGuiKey_Escape))
+        {
+            cancelEdit();
+        }
+        return;
+    }
 
     ImGui::SetNextItemWidth(-FLT_MIN);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
@@ -186,7 +685,7 @@ void Table::renderTableCellEdit(int row, int col)
         ImGui::SetKeyboardFocusHere();
     }
 
-    bool valueChanged = ImGui::InputTextMultiline(editId.c_str(), editBuffer, sizeof(editBuffer), ImVec2(-FLT_MIN, ImGui::GetTextLineHeight() * 3), ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine);
+    bool valueChanged = ImGui::InputTextMultiline("##Edit", editBuffer.data(), editBuffer.capacity() + 1, ImVec2(-FLT_MIN, ImGui::GetTextLineHeight() * 3), ImGuiInputTextFlags_AutoSelectAll | ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_CtrlEnterForNewLine | ImGuiInputTextFlags_CallbackResize, resizeEditBuffer, &editBuffer);
 
     ImGui::PopStyleVar();
 
@@ -213,24 +712,91 @@ void Table::renderPagination()
     ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
     ImGui::BeginChild("##Pagination", ImVec2(0, 30), false, ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse);
 
+    if (!pendingRows.empty())
+    {
+        renderPendingEditControls();
+        ImGui::SameLine();
+    }
+
     if (isFilterActive())
     {
         renderFilteringControls();
     }
     else
     {
-        renderPaginationControls();
+        if (streamRows)
+        {
+            renderStreamingControls();
+        }
+        else
+        {
+            renderPaginationControls();
+        }
         renderSortingControls();
     }
 
+    if (isLoading())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Loading...");
+    }
+    if (isLoading() || countingRows)
+    {
+        ImGui::SameLine();
+        if (ImGui::SmallButton("Cancel"))
+        {
+            cancelQueries();
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Stop the running page load and count on the server");
+        }
+    }
+
+    ImGui::SameLine();
+    renderExportControls();
+    ImGui::SameLine();
+    renderImportControls();
+
     ImGui::EndChild();
     ImGui::PopStyleVar();
 }
 
+void Table::renderPendingEditControls()
+{
+    ImGui::Text("%d pending change%s", pendingChangeCount(), pendingChangeCount() == 1 ? "" : "s");
+    ImGui::SameLine();
+    if (committingEdits)
+    {
+        ImGui::TextDisabled("Committing...");
+        return;
+    }
+    if (ImGui::Button("Commit"))
+    {
+        commitEdits();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Discard"))
+    {
+        discardEdits();
+    }
+}
+
 void Table::renderFilteringControls()
 {
     currentOffset = 0;
-    ImGui::Text("Found %d matching rows", static_cast<int>(rows.size()));
+    ImGui::Text("Found %d matching rows", rows.rowCount());
+    renderRowCount();
+    if (!filterScan.empty())
+    {
+        bool indexed = filterScan.find("Index") != std::string::npos;
+        ImGui::SameLine();
+        ImGui::TextColored(indexed ? ImVec4(0.4f, 0.8f, 0.4f, 1.0f) : ImVec4(0.9f, 0.7f, 0.3f, 1.0f), "%s", indexed ? "Index scan" : "Sequential scan");
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s", filterScan.c_str());
+        }
+    }
     ImGui::SameLine();
     if (ImGui::Button("Clear Search"))
     {
@@ -238,6 +804,7 @@ void Table::renderFilteringControls()
         {
             filter.clear();
         }
+        updateHeaderLabels();
         reloadWithFilters();
     }
 }
@@ -248,21 +815,20 @@ void Table::renderPaginationControls()
     {
         if (ImGui::Button("Previous"))
         {
-            currentOffset = std::max(0, currentOffset - rowsPerPage);
-            loadTableData(currentTable, currentOffset);
+            previousPage();
         }
         ImGui::SameLine();
     }
 
-    ImGui::Text("Page %d (rows %d-%d)", (currentOffset / rowsPerPage) + 1, static_cast<int>(currentOffset + 1), static_cast<int>(currentOffset + rows.size()));
+    ImGui::Text("Page %d (rows %d-%d)", (currentOffset / rowsPerPage) + 1, static_cast<int>(currentOffset + 1), currentOffset + rows.rowCount());
+    renderRowCount();
 
     if (hasMoreRows)
     {
         ImGui::SameLine();
         if (ImGui::Button("Next"))
         {
-            currentOffset += rowsPerPage;
-            loadTableData(currentTable, currentOffset);
+            nextPage();
         }
     }
 }
@@ -272,32 +838,87 @@ void Table::renderSortingControls()
     ImGui::SameLine();
     ImGui::SetNextItemWidth(100);
 
-    std::vector<const char *> colNames;
-    for (const auto &col : columns)
+    bool sortChanged = false;
+    if (ImGui::BeginCombo("Sort", columns[sortColumn].c_str()))
     {
-        colNames.push_back(col.c_str());
+        for (int i = 0; i < columns.size(); i++)
+        {
+            if (ImGui::Selectable(columns[i].c_str(), sortColumn == i))
+            {
+                sortChanged = sortColumn != i;
+                sortColumn = i;
+            }
+        }
+        ImGui::EndCombo();
     }
 
-    if (ImGui::Combo("Sort", &sortColumn, colNames.data(), (int)colNames.size()))
+    if (sortChanged)
     {
+        resetPageCursors();
         loadTableData(currentTable, currentOffset);
     }
 
     ImGui::SameLine();
     if (ImGui::Checkbox("Reverse", &sortAscending))
     {
+        resetPageCursors();
         loadTableData(currentTable, currentOffset);
     }
-}
 
-void Table::setupTableFlags(ImGuiTableFlags &flags) const { flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_ScrollX; }
-
-void Table::renderTableHeaders()
-{
-    ImGui::TableSetupScrollFreeze(0, 1);
-    for (const auto &col : columns)
+    ImGui::SameLine();
+    bool stream = streamRows;
+    if (ImGui::Checkbox("Stream", &stream))
+    {
+        setStreaming(stream);
+    }
+    if (ImGui::IsItemHovered())
     {
-        ImGui::TableSetupColumn(col.c_str(), ImGuiTableColumnFlags_None | ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_NoSort, ImGui::GetWindowWidth() * 0.1f);
+        ImGui::SetTooltip("Load the whole result progressively instead of one page at a time");
+    }
+
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Binary", &useBinaryResults))
+    {
+        loadTableData(currentTable, currentOffset);
+    }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Fetch results in binary format and decode them by column type");
+    }
+
+    if (!primaryKeyColumns.empty() && !streamRows)
+    {
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Keyset", &useKeysetPagination))
+        {
+            resetPageCursors();
+            loadTableData(currentTable, currentOffset);
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Seek past the last row of the previous page instead of using OFFSET");
+        }
+    }
+
+    if (!sortKeys.empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Sorted %d rows in %.1f ms", rows.rowCount(), lastSortMillis);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Header sort of the loaded rows; Shift+click a header to add a column");
+        }
+    }
+}
+
+void Table::setupTableFlags(ImGuiTableFlags &flags) const { flags = ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable | ImGuiTableFlags_SortMulti | ImGuiTableFlags_SortTristate | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_ScrollX; }
+
+void Table::renderTableHeaders()
+{
+    ImGui::TableSetupScrollFreeze(0, 1);
+    for (const auto &col : columns)
+    {
+        ImGui::TableSetupColumn(col.c_str(), ImGuiTableColumnFlags_None | ImGuiTableColumnFlags_WidthFixed, ImGui::GetWindowWidth() * 0.1f);
     }
 
     // Custom header row that combines headers and filters
@@ -320,8 +941,6 @@ bool Table::shouldShowFilter(size_t colIndex) const { return activeFilterColumn
 
 void Table::renderFilterInput(size_t colIndex)
 {
-    std::string filterId = "##Filter" + std::to_string(colIndex);
-
     ImGui::SetNextItemWidth(-FLT_MIN);
     ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
 
@@ -335,11 +954,17 @@ void Table::renderFilterInput(size_t colIndex)
     filterBuffer[sizeof(filterBuffer) - 1] = '\0';
 
     bool filterChanged = false;
-    if (ImGui::InputText(filterId.c_str(), filterBuffer, sizeof(filterBuffer), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_AutoSelectAll))
+    ImGui::PushID(static_cast<int>(colIndex));
+    if (ImGui::InputText("##Filter", filterBuffer, sizeof(filterBuffer), ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_AutoSelectAll))
     {
         filterChanged = true;
     }
 
+    if (ImGui::IsItemActive() && filterBuffer[0] != '\0')
+    {
+        ImGui::SetTooltip("%s\nSyntax: value, =v, !=v, <v, >=v, a..b, prefix*, null, !null", describeFilter(colIndex, filterBuffer).c_str());
+    }
+
     if (ImGui::IsItemDeactivated() && ImGui::IsKeyPressed(ImGuiKey_Escape))
     {
         filterBuffer[0] = '\0';
@@ -348,8 +973,7 @@ void Table::renderFilterInput(size_t colIndex)
 
     if (filterChanged)
     {
-        columnFilters[colIndex] = filterBuffer;
-        reloadWithFilters();
+        setFilter(colIndex, filterBuffer);
         activeFilterColumn = -1;
         lastActiveColumn = -1;
     }
@@ -364,56 +988,177 @@ void Table::renderFilterInput(size_t colIndex)
         lastActiveColumn = -1;
     }
 
+    ImGui::PopID();
     ImGui::PopStyleVar();
 }
 
 void Table::renderHeaderCell(size_t colIndex)
 {
-    std::string headerText = columns[colIndex];
-    if (!columnFilters[colIndex].empty())
-    {
-        headerText += " (*)";
-    }
+    // Clicking the header sorts (Shift adds a column); the small button on its right opens the filter
+    float buttonWidth = ImGui::CalcTextSize("F").x + 4;
+    float cellStart = ImGui::GetCursorPosX();
+    float cellWidth = ImGui::GetContentRegionAvail().x;
 
-    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 2));
-    if (ImGui::Selectable(headerText.c_str(), false, ImGuiSelectableFlags_None, ImVec2(ImGui::GetColumnWidth(), ImGui::GetTextLineHeight())))
+    ImGui::SetNextItemAllowOverlap();
+    ImGui::TableHeader(headerLabels[colIndex].c_str());
+    ImGui::SameLine();
+    ImGui::SetCursorPosX(cellStart + std::max(0.0f, cellWidth - buttonWidth));
+
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(2, 0));
+    ImGui::PushID(static_cast<int>(colIndex));
+    if (ImGui::SmallButton(columnFilters[colIndex].empty() ? "F" : "F*"))
     {
         activeFilterColumn = colIndex;
         strncpy(filterBuffer, columnFilters[colIndex].c_str(), sizeof(filterBuffer) - 1);
     }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("%s", columnFilters[colIndex].empty() ? "Filter this column" : describeFilter(colIndex, columnFilters[colIndex]).c_str());
+    }
+    ImGui::PopID();
     ImGui::PopStyleVar();
 }
 
 void Table::handleCellClick(int row, int col)
 {
+    // A preview must never be saved back over the value it was cut from, so truncated cells open only with their full value
+    const std::string *pending = findPendingValue(row, col);
+    bool truncated = !pending && isTruncated(row, col);
+    if (truncated && !canLoadFullValue(row))
+        return;
+
     editRow = row;
     editCol = col;
     isEditing = true;
-    strncpy(editBuffer, rows[row][col].c_str(), sizeof(editBuffer) - 1);
+    loadingFullValue = truncated;
+    editBuffer = truncated ? std::string() : pending ? *pending : rows.text(row, col);
+    editOriginal = editBuffer;
+    if (truncated)
+    {
+        requestFullValue(row, col);
+    }
 }
 
-void Table::saveEdit()
+int Table::resizeEditBuffer(ImGuiInputTextCallbackData *data)
 {
-    if (!isEditing || editRow < 0 || editCol < 0)
-        return;
+    // ImGui asks for room before the text outgrows the buffer; the string's own growth policy keeps this rare
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackResize)
+    {
+        auto *buffer = static_cast<std::string *>(data->UserData);
+        buffer->resize(data->BufTextLen);
+        data->Buf = buffer->data();
+    }
+    return 0;
+}
 
-    std::string query = generateUpdateQuery(editRow, editCol, editBuffer);
-    PGresult *res = PQexec(conn, query.c_str());
+bool Table::canLoadFullValue(int row) const
+{
+    if (!rowKeyColumns.empty())
+        return std::none_of(rowKeyColumns.begin(), rowKeyColumns.end(), [this, row](int col) { return rows.isNull(row, col) || isTruncated(row, col); });
+    return identifyByCtid && hiddenColumn(CtidColumn) >= 0;
+}
 
-    if (PQresultStatus(res) == PGRES_COMMAND_OK)
+void Table::requestFullValue(int row, int col)
+{
+    SqlQuery query;
+    std::string conditions;
+    if (!rowKeyColumns.empty())
     {
-        // Update successful, update local data
-        rows[editRow][editCol] = editBuffer;
+        for (int key : rowKeyColumns)
+        {
+            conditions += (conditions.empty() ? "" : " AND ") + SchemaCatalog::quoteIdentifier(columns[key]) + " = " + query.bind(rows.text(row, key));
+        }
     }
     else
     {
-        std::cerr << "Update failed: " << PQerrorMessage(conn) << std::endl;
+        conditions = "ctid = " + query.bind(rows.text(row, hiddenColumn(CtidColumn))) + "::tid";
     }
+    query.sql = "SELECT " + SchemaCatalog::quoteIdentifier(columns[col]) + "::text FROM " + relationName + " WHERE " + conditions;
+
+    int request = ++fullValueRequest;
+    StatementCache *statements = &executor->statements();
+    executor->submit(this,
+                     [this, request, query, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         ResultPtr result = executeQuery(conn, *statements, query);
+                         bool found = result && PQntuples(result.get()) > 0;
+                         std::string value = found ? std::string(PQgetvalue(result.get(), 0, 0), PQgetlength(result.get(), 0, 0)) : "";
+                         return [this, request, found, value = std::move(value)]()
+                         {
+                             if (request != fullValueRequest || !loadingFullValue)
+                                 return;
+
+                             loadingFullValue = false;
+                             if (!found)
+                             {
+                                 std::cerr << "Full value not found; the row was changed or deleted" << std::endl;
+                                 cancelEdit();
+                                 return;
+                             }
+                             editBuffer = value;
+                             editOriginal = value;
+                         };
+                     });
+}
 
-    PQclear(res);
-    isEditing = false;
-    editRow = -1;
-    editCol = -1;
+void Table::saveEdit()
+{
+    if (!isEditing || editRow < 0 || editCol < 0 || loadingFullValue)
+        return;
+
+    // The buffer's size may lag behind the text ImGui wrote into it; the text ends at the terminator
+    int row = editRow;
+    int col = editCol;
+    std::string newValue = editBuffer.c_str();
+    bool unchanged = newValue == editOriginal && !findPendingValue(row, col);
+    cancelEdit();
+    if (!unchanged)
+    {
+        stageEdit(row, col, newValue);
+    }
+}
+
+void Table::stageEdit(int row, int col, const std::string &newValue)
+{
+    if (row < 0 || row >= rows.rowCount() || col < 0 || col >= static_cast<int>(columns.size()))
+        return;
+
+    auto key = std::make_pair(pageVersion, row);
+    auto it = pendingRows.find(key);
+    if (it == pendingRows.end())
+    {
+        if (!rows.isNull(row, col) && rows.text(row, col) == newValue)
+            return;
+
+        // The row is identified by the values it had when first edited, so the change stays valid after the page is replaced
+        PendingRow pending;
+        pending.table = relationName;
+        pending.resultFormat = rows.isBinary() ? 1 : 0;
+        for (int i = 0; i < static_cast<int>(columns.size()); i++)
+        {
+            pending.columnNames.push_back(columns[i]);
+            pending.originalNull.push_back(rows.isNull(row, i));
+            pending.original.push_back(rows.text(row, i));
+            pending.originalPreview.push_back(i < static_cast<int>(sizeColumns.size()) && sizeColumns[i] >= 0);
+        }
+        pending.keyColumns = rowKeyColumns;
+        int versionCol = hiddenColumn(RowVersionColumn);
+        int ctidCol = hiddenColumn(CtidColumn);
+        if (versionCol >= 0)
+        {
+            pending.rowVersion = rows.text(row, versionCol);
+        }
+        if (ctidCol >= 0)
+        {
+            pending.ctid = rows.text(row, ctidCol);
+        }
+        it = pendingRows.emplace(key, std::move(pending)).first;
+    }
+
+    PendingRow &pending = it->second;
+    pending.changes[col] = {newValue, selectExpression(col), previewsColumn(col) ? sizeExpression(SchemaCatalog::quoteIdentifier(columns[col]), columnTypes[col], col) : ""};
+    pending.error.clear();
+    pending.revision++;
 }
 
 void Table::cancelEdit()
@@ -421,153 +1166,1538 @@ void Table::cancelEdit()
     isEditing = false;
     editRow = -1;
     editCol = -1;
+    loadingFullValue = false;
+    editBuffer = std::string();
+    editOriginal = std::string();
 }
 
-std::string Table::generateUpdateQuery(int row, int col, const std::string &newValue)
+const std::string *Table::findPendingValue(int row, int col) const
 {
-    // Use quoted identifiers for table and column names
-    std::string query = "UPDATE \"" + currentTable + "\" SET \"" + columns[editCol] + "\" = '" + newValue + "' WHERE ";
+    if (pendingRows.empty())
+        return nullptr;
 
-    // Use all columns for WHERE clause to uniquely identify the row
-    bool first = true;
-    for (size_t i = 0; i < columns.size(); i++)
+    auto it = pendingRows.find(std::make_pair(pageVersion, row));
+    if (it == pendingRows.end())
+        return nullptr;
+
+    auto change = it->second.changes.find(col);
+    return change == it->second.changes.end() ? nullptr : &change->second.value;
+}
+
+int Table::pendingChangeCount() const
+{
+    int count = 0;
+    for (const auto &entry : pendingRows)
     {
-        if (!first)
-            query += " AND ";
-        query += "\"" + columns[i] + "\" = '" + rows[row][i] + "'";
-        first = false;
+        count += static_cast<int>(entry.second.changes.size());
     }
-
-    std::cout << "Executing update query: " << query << std::endl; // Debug output
-    return query;
+    return count;
 }
 
-void Table::checkForMoreRows()
+void Table::commitEdits()
 {
-    if (!conn)
+    if (pendingRows.empty() || committingEdits)
         return;
 
-    std::string countQuery = "SELECT EXISTS(SELECT 1 FROM \"" + currentTable + "\" LIMIT 1 OFFSET " + std::to_string(currentOffset + rowsPerPage) + ")";
-
-    PGresult *res = PQexec(conn, countQuery.c_str());
-    if (PQresultStatus(res) == PGRES_TUPLES_OK)
+    // Snapshot keys and revisions; rows edited again while the commit runs stay pending
+    std::vector<std::pair<std::pair<int, int>, int>> committed;
+    std::vector<SqlQuery> queries;
+    for (const auto &entry : pendingRows)
     {
-        hasMoreRows = std::string(PQgetvalue(res, 0, 0)) == "t";
+        committed.push_back({entry.first, entry.second.revision});
+        queries.push_back(generateUpdateQuery(entry.second));
     }
-    PQclear(res);
+
+    committingEdits = true;
+    StatementCache *statements = &executor->statements();
+
+    executor->submit(this,
+                     [this, committed, queries, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         std::vector<ResultPtr> results;
+                         std::vector<std::string> errors;
+                         bool success = executeInTransaction(conn, *statements, queries, results, errors);
+
+                         // Returned rows are decoded here so the UI thread only copies cells
+                         std::vector<PagePtr> returned(results.size());
+                         for (size_t i = 0; i < results.size(); i++)
+                         {
+                             if (results[i] && PQntuples(results[i].get()) > 0)
+                             {
+                                 returned[i] = loadRows(results[i].get(), 1);
+                             }
+                             else if (results[i] && errors[i].empty())
+                             {
+                                 errors[i] = "Conflict: the row was changed or deleted since it was loaded; discard and reload to edit it again";
+                             }
+                         }
+
+                         return [this, committed, returned, errors, success]() { applyCommittedEdits(committed, returned, errors, success); };
+                     });
 }
 
-void Table::handleSorting()
+void Table::applyCommittedEdits(const std::vector<std::pair<std::pair<int, int>, int>> &committed, const std::vector<PagePtr> &returned, const std::vector<std::string> &errors, bool success)
 {
-    ImGuiTableSortSpecs *sorts_specs = ImGui::TableGetSortSpecs();
-    if (sorts_specs && sorts_specs->SpecsDirty)
+    committingEdits = false;
+
+    std::set<std::string> changedTables;
+    for (size_t i = 0; i < committed.size(); i++)
     {
-        currentSort = sorts_specs;
+        auto it = pendingRows.find(committed[i].first);
+        if (it == pendingRows.end())
+            continue;
+
+        PendingRow &pending = it->second;
+        if (!success || !returned[i])
+        {
+            // Nothing was written; the change stays pending so it can be fixed, retried or discarded
+            if (!errors[i].empty())
+            {
+                pending.error = errors[i];
+            }
+            else if (!success)
+            {
+                pending.error = "Not applied; another change in the transaction failed";
+            }
+            continue;
+        }
+
+        // Copy the server's values into the page if it is still the one the edit was made on
+        changedTables.insert(pending.table);
+        if (committed[i].first.first == pageVersion)
+        {
+            int row = committed[i].first.second;
+            int index = 0;
+            for (const auto &change : pending.changes)
+            {
+                if (row < rows.rowCount() && index < returned[i]->columnCount())
+                {
+                    rows.setCell(row, change.first, *returned[i], 0, index);
+                }
+                index++;
+            }
+            rowsVersion++;
 
-        if (currentSort->SpecsCount > 0)
+            // The update gave the row a new version and location; later edits of it must use them
+            for (; index < returned[i]->columnCount() && row < rows.rowCount(); index++)
+            {
+                int col = hiddenColumn(returned[i]->columnName(index).c_str());
+                if (col >= 0)
+                {
+                    rows.setCell(row, col, *returned[i], 0, index);
+                }
+            }
+            displayRowsDirty = true;
+        }
+        for (int col = static_cast<int>(pending.changes.size()); col < returned[i]->columnCount(); col++)
+        {
+            if (returned[i]->columnName(col) == RowVersionColumn)
+            {
+                pending.rowVersion = returned[i]->text(0, col);
+            }
+            else if (returned[i]->columnName(col) == CtidColumn)
+            {
+                pending.ctid = returned[i]->text(0, col);
+            }
+        }
+        if (pending.revision == committed[i].second)
         {
-            std::sort(rows.begin(), rows.end(), [this](const std::vector<std::string> &a, const std::vector<std::string> &b) { return this->compareRows(a, b); });
+            pendingRows.erase(it);
         }
+    }
 
-        sorts_specs->SpecsDirty = false;
+    // Cached pages of these tables may now hold the old values
+    for (const auto &relation : changedTables)
+    {
+        if (pageCache)
+        {
+            pageCache->invalidate(relation);
+        }
     }
 }
 
-bool Table::compareRows(const std::vector<std::string> &a, const std::vector<std::string> &b) const
+void Table::discardEdits()
 {
-    if (!currentSort || currentSort->SpecsCount == 0)
-        return false;
+    pendingRows.clear();
+    cancelEdit();
+}
 
-    for (int i = 0; i < currentSort->SpecsCount; i++)
+SqlQuery Table::generateUpdateQuery(const PendingRow &pending) const
+{
+    // Use quoted identifiers for table and column names; values are bound, so the shape is table, changed columns and NULL pattern
+    SqlQuery query;
+    query.resultFormat = pending.resultFormat;
+    std::string assignments;
+    std::string returning;
+    for (const auto &change : pending.changes)
     {
-        const ImGuiTableColumnSortSpecs *sort_spec = &currentSort->Specs[i];
-        int col = sort_spec->ColumnIndex;
-        if (col >= a.size() || col >= b.size())
-            continue;
+        assignments += (assignments.empty() ? "" : ", ") + SchemaCatalog::quoteIdentifier(pending.columnNames[change.first]) + " = " + query.bind(change.second.value);
+        returning += (returning.empty() ? "" : ", ") + change.second.returning;
+    }
+    for (const auto &change : pending.changes)
+    {
+        if (!change.second.size.empty())
+        {
+            returning += ", " + change.second.size;
+        }
+    }
+
+    // The row is found by ctid or by key, each a single lookup; matching every column is the last resort (views, pages loaded before keys were known)
+    std::string conditions;
+    if (!pending.ctid.empty())
+    {
+        conditions = "ctid = " + query.bind(pending.ctid) + "::tid";
+    }
+    else if (!pending.keyColumns.empty())
+    {
+        for (int col : pending.keyColumns)
+        {
+            conditions += (conditions.empty() ? "" : " AND ") + SchemaCatalog::quoteIdentifier(pending.columnNames[col]) + " = " + query.bind(pending.original[col]);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < pending.columnNames.size(); i++)
+        {
+            // A previewed value is compared with the same prefix of the stored one
+            std::string column = SchemaCatalog::quoteIdentifier(pending.columnNames[i]);
+            conditions += i > 0 ? " AND " : "";
+            if (pending.originalNull[i])
+                conditions += column + " IS NULL";
+            else if (pending.originalPreview[i])
+                conditions += "left(" + column + "::text, " + std::to_string(PreviewLength) + ") = " + query.bind(pending.original[i]);
+            else
+                conditions += column + " = " + query.bind(pending.original[i]);
+        }
+    }
 
-        int cmp = a[col].compare(b[col]);
-        if (cmp != 0)
-            return sort_spec->SortDirection == ImGuiSortDirection_Ascending ? cmp < 0 : cmp > 0;
+    // The row version makes the update optimistic: a row changed since it was read no longer matches
+    if (!pending.rowVersion.empty())
+    {
+        conditions += " AND xmin = " + query.bind(pending.rowVersion) + "::xid";
+        returning += std::string(", xmin::text AS ") + RowVersionColumn;
     }
-    return false;
+    if (!pending.ctid.empty())
+    {
+        returning += std::string(", ctid::text AS ") + CtidColumn;
+    }
+
+    // RETURNING hands back the stored values in the same format as the page they go into
+    query.sql = "UPDATE " + pending.table + " SET " + assignments + " WHERE " + conditions + " RETURNING " + returning;
+    return query;
 }
 
-bool Table::shouldShowRow(const std::vector<std::string> &row) const
+bool Table::executeInTransaction(PGconn *conn, StatementCache &statements, const std::vector<SqlQuery> &queries, std::vector<ResultPtr> &results, std::vector<std::string> &errors)
 {
-    if (columnFilters.size() != columns.size() || row.size() != columns.size())
+    results.assign(queries.size(), nullptr);
+    errors.assign(queries.size(), "");
+
+#ifndef LIBPQ_HAS_PIPELINING
+    // libpq before 14 has no pipeline mode: same transaction, one round trip per statement
+    PQclear(PQexec(conn, "BEGIN"));
+    bool failed = false;
+    for (size_t i = 0; i < queries.size() && !failed; i++)
     {
-        return true; // Safety check: if sizes don't match, show the row
+        PGresult *result = statements.execute(conn, queries[i]);
+        failed = PQresultStatus(result) != PGRES_TUPLES_OK;
+        if (failed)
+        {
+            errors[i] = PQresultErrorMessage(result);
+            PQclear(result);
+        }
+        else
+        {
+            results[i] = ResultPtr(result, PQclear);
+        }
     }
-
-    for (size_t i = 0; i < columns.size(); i++)
+    PGresult *end = PQexec(conn, failed ? "ROLLBACK" : "COMMIT");
+    bool committed = !failed && PQresultStatus(end) == PGRES_COMMAND_OK;
+    PQclear(end);
+    return committed;
+#else
+    // Statements are prepared first; synchronous calls are not allowed inside a pipeline. Preparing more shapes
+    // than the cache holds would deallocate this batch's first statements before they are sent, so such a
+    // batch is sent unprepared instead.
+    std::unordered_set<std::string> shapes;
+    for (const auto &query : queries)
     {
-        if (!columnFilters[i].empty())
-        { // If filter is not empty
-            std::string filter = columnFilters[i];
-            std::string value = row[i];
-            // Convert both to lowercase for case-insensitive search
-            std::transform(filter.begin(), filter.end(), filter.begin(), ::tolower);
-            std::transform(value.begin(), value.end(), value.begin(), ::tolower);
-            if (value.find(filter) == std::string::npos)
-                return false;
+        shapes.insert(StatementCache::shapeKey(query));
+    }
+    bool prepared = shapes.size() <= statements.maxSize();
+    std::vector<std::string> names;
+    for (size_t i = 0; prepared && i < queries.size(); i++)
+    {
+        const char *name = statements.prepare(conn, queries[i]);
+        if (!name)
+        {
+            errors[i] = PQerrorMessage(conn);
+            return false;
         }
+        names.push_back(name);
     }
-    return true;
-}
 
-std::string Table::buildFilteredQuery() const
-{
-    std::string query = "SELECT * FROM \"" + currentTable + "\" WHERE 1=1";
+    if (!PQenterPipelineMode(conn))
+    {
+        std::cerr << "Pipeline mode unavailable: " << PQerrorMessage(conn) << std::endl;
+        return false;
+    }
 
-    for (size_t i = 0; i < columns.size(); i++)
+    // Results are read back in send order: one result plus a NULL per statement, then a marker per sync.
+    // Syncing every few hundred statements keeps socket buffers from filling while the server waits on us.
+    constexpr int Begin = -1;
+    constexpr int Commit = -2;
+    constexpr int Sync = -3;
+    constexpr int SyncInterval = 256;
+    std::deque<int> expected;
+    bool failed = false;
+    bool committed = false;
+
+    // Every expected result is read even after a failure, so the pipeline can be left cleanly
+    auto drain = [&]()
     {
-        if (!columnFilters[i].empty())
+        while (!expected.empty())
+        {
+            int tag = expected.front();
+            expected.pop_front();
+            PGresult *result = PQgetResult(conn);
+            if (!result)
+            {
+                failed = true;
+                break;
+            }
+
+            ExecStatusType status = PQresultStatus(result);
+            if (tag == Sync)
+            {
+                PQclear(result);
+                continue;
+            }
+
+            if (status == PGRES_FATAL_ERROR || status == PGRES_PIPELINE_ABORTED)
+            {
+                failed = true;
+            }
+            if (status == PGRES_FATAL_ERROR)
+            {
+                std::cerr << "Update failed: " << PQresultErrorMessage(result) << std::endl;
+                if (tag >= 0)
+                {
+                    errors[tag] = PQresultErrorMessage(result);
+                }
+            }
+            if (tag >= 0 && status == PGRES_TUPLES_OK)
+            {
+                results[tag] = ResultPtr(result, PQclear);
+            }
+            else
+            {
+                // An aborted transaction answers COMMIT with success and the tag ROLLBACK
+                committed = committed || (tag == Commit && status == PGRES_COMMAND_OK && std::strcmp(PQcmdStatus(result), "COMMIT") == 0);
+                PQclear(result);
+            }
+            PQclear(PQgetResult(conn)); // End of this statement's results
+        }
+    };
+
+    // Only what was actually queued is expected back; a send that failed leaves nothing to read
+    auto sent = [&](int ok, int tag)
+    {
+        if (ok)
+        {
+            expected.push_back(tag);
+            return;
+        }
+        std::cerr << "Update not sent: " << PQerrorMessage(conn) << std::endl;
+        if (tag >= 0)
+        {
+            errors[tag] = PQerrorMessage(conn);
+        }
+        failed = true;
+    };
+
+    sent(PQsendQueryParams(conn, "BEGIN", 0, nullptr, nullptr, nullptr, nullptr, 0), Begin);
+    for (size_t i = 0; i < queries.size() && !failed; i++)
+    {
+        const SqlQuery &query = queries[i];
+        std::vector<const char *> values;
+        for (const auto &param : query.params)
+        {
+            values.push_back(param.c_str());
+        }
+        int count = static_cast<int>(values.size());
+        if (prepared)
+        {
+            sent(PQsendQueryPrepared(conn, names[i].c_str(), count, values.data(), nullptr, nullptr, query.resultFormat), static_cast<int>(i));
+        }
+        else
+        {
+            const Oid *types = query.paramTypes.empty() ? nullptr : query.paramTypes.data();
+            sent(PQsendQueryParams(conn, query.sql.c_str(), count, types, values.data(), nullptr, nullptr, query.resultFormat), static_cast<int>(i));
+        }
+
+        if ((i + 1) % SyncInterval == 0)
         {
-            query += " AND LOWER(\"" + columns[i] + "\"::text) LIKE LOWER('%" + columnFilters[i] + "%')";
+            sent(PQpipelineSync(conn), Sync);
+            drain();
         }
     }
-    // Incorporate the selected sort column and order.
-    query += " ORDER BY \"" + columns[sortColumn] + "\" " + (sortAscending ? "ASC" : "DESC");
-    query += " LIMIT " + std::to_string(rowsPerPage) + " OFFSET " + std::to_string(currentOffset);
+
+    // Within a sync segment a failure skips the rest, COMMIT included; after an earlier segment failed the
+    // transaction block is aborted, so it is ended with ROLLBACK instead
+    sent(PQsendQueryParams(conn, failed ? "ROLLBACK" : "COMMIT", 0, nullptr, nullptr, nullptr, nullptr, 0), Commit);
+    sent(PQpipelineSync(conn), Sync);
+    drain();
+
+    PQexitPipelineMode(conn);
+    if (PQtransactionStatus(conn) != PQTRANS_IDLE)
+    {
+        PQclear(PQexec(conn, "ROLLBACK"));
+    }
+    return committed && !failed;
+#endif
+}
+
+std::string Table::rowCountKey() const
+{
+    std::string key = currentTable;
+    for (const auto &filter : columnFilters)
+    {
+        key += '\x1f' + filter;
+    }
+    return key;
+}
+
+SqlQuery Table::buildCountQuery(const std::string &select) const
+{
+    SqlQuery query;
+    query.sql = select + " FROM " + relationName + " WHERE 1=1" + buildFilterClause(query);
     return query;
 }
-void Table::clearAndExecuteQuery(const std::string &query, PGresult *&result)
+
+void Table::requestRowEstimate()
 {
-    rows.clear();
-    executeQuery(query, result); // Using our existing executeQuery function
+    // Estimates are per table and filter set, so paging through a result costs nothing extra
+    std::string key = rowCountKey();
+    if (key == countKey)
+        return;
+
+    pool->cancel(countOwner());
+    countKey = key;
+    estimatedRows = -1;
+    exactRows = -1;
+    countingRows = false;
+    filterScan.clear();
+
+    std::string relation = relationName;
+    bool filtered = isFilterActive();
+    SqlQuery explain = buildCountQuery("EXPLAIN SELECT 1");
+    QueryExecutor *background = pool->background();
+    StatementCache *statements = &background->statements();
+
+    background->submit(countOwner(),
+                     [this, key, relation, filtered, explain, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         std::string scan;
+                         long long estimate = fetchRowEstimate(conn, *statements, relation, filtered, explain, scan);
+                         return [this, key, estimate, scan]()
+                         {
+                             if (key == countKey)
+                             {
+                                 estimatedRows = estimate;
+                                 filterScan = scan;
+                             }
+                         };
+                     });
 }
 
-void Table::loadRowsFromResult(PGresult *result)
+long long Table::fetchRowEstimate(PGconn *conn, StatementCache &statements, const std::string &relation, bool filtered, const SqlQuery &explain, std::string &scan)
 {
-    int numRows = PQntuples(result);
-    int numCols = PQnfields(result);
+    long long estimate = -1;
+    if (!filtered)
+    {
+        // The statistics row count is free; it is -1 (or 0 on older servers) until the table has been analyzed
+        SqlQuery query;
+        query.sql = "SELECT reltuples::bigint FROM pg_class WHERE oid = " + query.bind(relation) + "::regclass";
+        PGresult *result = statements.execute(conn, query);
+        if (PQresultStatus(result) == PGRES_TUPLES_OK && PQntuples(result) > 0)
+        {
+            estimate = std::atoll(PQgetvalue(result, 0, 0));
+        }
+        PQclear(result);
+        if (estimate > 0)
+            return estimate;
+    }
 
-    rows.reserve(numRows);
-    for (int i = 0; i < numRows; i++)
+    // The planner's estimate for the filtered scan: "... (cost=0.00..1.23 rows=N width=W)" on the top plan line
+    PGresult *result = statements.execute(conn, explain);
+    if (PQresultStatus(result) == PGRES_TUPLES_OK && PQntuples(result) > 0)
     {
-        std::vector<std::string> row;
-        row.reserve(numCols);
-        for (int j = 0; j < numCols; j++)
+        const char *rows = strstr(PQgetvalue(result, 0, 0), "rows=");
+        if (rows)
+        {
+            estimate = std::atoll(rows + 5);
+        }
+
+        // The first index scan node if there is one (a bitmap heap scan names its index on a child line), else the first scan
+        for (int i = 0; i < PQntuples(result); i++)
         {
-            row.push_back(PQgetisnull(result, i, j) ? "NULL" : PQgetvalue(result, i, j));
+            std::string line = PQgetvalue(result, i, 0);
+            if (line.find(" Scan") == std::string::npos || (!scan.empty() && line.find("Index") == std::string::npos))
+                continue;
+
+            size_t begin = line.find_first_not_of(" ->");
+            scan = line.substr(begin, line.find("  (cost") - begin);
+            if (scan.find("Index") != std::string::npos)
+                break;
         }
-        rows.push_back(std::move(row));
     }
+    else
+    {
+        std::cerr << "Row estimate failed: " << PQerrorMessage(conn) << std::endl;
+    }
+    PQclear(result);
+    return estimate;
 }
 
-void Table::reloadWithFilters()
+void Table::requestExactCount()
 {
-    if (!conn)
+    if (countingRows)
         return;
 
-    std::string dataQuery = buildFilteredQuery();
-    PGresult *dataRes = nullptr;
+    countingRows = true;
+    std::string key = countKey;
+    SqlQuery query = buildCountQuery("SELECT count(*)");
+    QueryExecutor *background = pool->background();
+    StatementCache *statements = &background->statements();
+
+    background->submit(countOwner(),
+                     [this, key, query, statements](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         ResultPtr result = executeQuery(conn, *statements, query);
+                         long long count = result && PQntuples(result.get()) > 0 ? std::atoll(PQgetvalue(result.get(), 0, 0)) : -1;
+                         return [this, key, count]()
+                         {
+                             if (key == countKey)
+                             {
+                                 exactRows = count;
+                                 countingRows = false;
+                             }
+                         };
+                     });
+}
+
+void Table::renderRowCount()
+{
+    ImGui::SameLine();
+    if (exactRows >= 0)
+    {
+        ImGui::Text("of %lld", exactRows);
+        return;
+    }
 
-    clearAndExecuteQuery(dataQuery, dataRes);
-    if (!dataRes)
+    if (estimatedRows >= 0)
+    {
+        ImGui::TextDisabled("of ~%lld", estimatedRows);
+        ImGui::SameLine();
+    }
+    if (countingRows)
+    {
+        ImGui::TextDisabled("Counting...");
         return;
+    }
+    if (ImGui::SmallButton("Count"))
+    {
+        requestExactCount();
+    }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Run an exact count(*) in the background");
+    }
+}
 
-    loadRowsFromResult(dataRes);
-    PQclear(dataRes);
-    checkForMoreRows();
-}
\ No newline at end of file
+void Table::handleSorting()
+{
+    // Specs are only valid for the current frame, so the keys are copied out
+    ImGuiTableSortSpecs *sorts_specs = ImGui::TableGetSortSpecs();
+    if (sorts_specs && sorts_specs->SpecsDirty)
+    {
+        sortKeys.clear();
+        for (int i = 0; i < sorts_specs->SpecsCount; i++)
+        {
+            const ImGuiTableColumnSortSpecs &spec = sorts_specs->Specs[i];
+            sortKeys.push_back({spec.ColumnIndex, spec.SortDirection == ImGuiSortDirection_Descending});
+        }
+        sorts_specs->SpecsDirty = false;
+        rowOrderDirty = true;
+    }
+
+    if (rowOrderDirty)
+    {
+        sortRows();
+    }
+}
+
+void Table::sortRows()
+{
+    // With no keys the rows go back to the server's order
+    Trace::Scope trace("sort", "ui");
+    auto start = std::chrono::steady_clock::now();
+    RowSorter::sort(rows, sortKeys, rowOrder);
+    lastSortMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    rowOrderDirty = false;
+    displayRowsDirty = true;
+}
+
+bool Table::shouldShowRow(int row) const
+{
+    if (columnFilters.size() != columns.size() || rows.columnCount() < static_cast<int>(columns.size()))
+    {
+        return true; // Safety check: if sizes don't match, show the row
+    }
+
+    // Match bitmaps are brought up to date by updateFilterMatches() before rows are tested
+    for (const auto &filter : compiledFilters)
+    {
+        if (!filter.search.empty() && !((filter.matches[row >> 6] >> (row & 63)) & 1))
+            return false;
+    }
+    return true;
+}
+
+void Table::updateFilterMatches()
+{
+    int rowCount = rows.rowCount();
+    int columnCount = std::min(static_cast<int>(columnFilters.size()), rows.columnCount());
+    compiledFilters.resize(columnCount);
+
+    std::string scratch;
+    for (int col = 0; col < columnCount; col++)
+    {
+        CompiledFilter &filter = compiledFilters[col];
+        if (filter.text != columnFilters[col] || filter.rowsVersion != rowsVersion)
+        {
+            // Only substring filters typed since the rows were requested are checked on the client; the server
+            // already applied the others with its own case folding and formatting, and typed predicates are its alone
+            ColumnFilter parsed = parseFilter(col, columnFilters[col]);
+            bool serverFiltered = col < static_cast<int>(rowsFilters.size()) && rowsFilters[col] == columnFilters[col];
+            filter.text = columnFilters[col];
+            filter.search = !serverFiltered && parsed.op() == ColumnFilter::Op::Contains ? TextSearch(parsed.value()) : TextSearch();
+            filter.rowsVersion = rowsVersion;
+            filter.matches.clear();
+            filter.coveredRows = 0;
+        }
+        if (filter.search.empty() || filter.coveredRows == rowCount)
+            continue;
+
+        // NULL cells never match; other cells are searched as their full text, formatted without allocating where possible
+        filter.matches.resize((rowCount + 63) / 64, 0);
+        for (int row = filter.coveredRows; row < rowCount; row++)
+        {
+            // A preview that was cut short may match past its end, so it stays until the server has checked it
+            if (!rows.isNull(row, col) && (isTruncated(row, col) || filter.search.matches(rows.textView(row, col, scratch))))
+            {
+                filter.matches[row >> 6] |= uint64_t(1) << (row & 63);
+            }
+        }
+        filter.coveredRows = rowCount;
+    }
+}
+
+std::string Table::buildFilterClause(SqlQuery &query) const
+{
+    // Filter values are bound, so the statement is shaped by the filtered columns and their operators only
+    std::string clause;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        if (!columnFilters[i].empty())
+        {
+            ColumnFilter filter = parseFilter(i, columnFilters[i]);
+            clause += " AND " + filter.buildPredicate(SchemaCatalog::quoteIdentifier(columns[i]), query, filter.plan(catalogRelation(), static_cast<int>(i)));
+        }
+    }
+    return clause;
+}
+
+ColumnFilter Table::parseFilter(size_t colIndex, const std::string &text) const { return ColumnFilter(text, colIndex < columnTypes.size() ? columnTypes[colIndex] : 0); }
+
+std::string Table::describeFilter(size_t colIndex, const std::string &text) const
+{
+    ColumnFilter filter = parseFilter(colIndex, text);
+    return filter.describe(filter.plan(catalogRelation(), static_cast<int>(colIndex)));
+}
+
+const SchemaCatalog::Relation *Table::catalogRelation() const
+{
+    // Column positions in the catalog only line up with ours while both describe the same columns
+    const SchemaCatalog::Relation *relation = catalog ? catalog->find(currentTable) : nullptr;
+    return relation && relation->columns.size() == columns.size() ? relation : nullptr;
+}
+
+std::string Table::buildSelect(SqlQuery &query) const { return "SELECT " + buildSelectList() + " FROM " + relationName + " AS " + RelationAlias + " WHERE 1=1" + buildFilterClause(query); }
+
+std::string Table::orderColumn(int col) const { return std::string(RelationAlias) + "." + SchemaCatalog::quoteIdentifier(columns[col]); }
+
+bool Table::fetchesBinary() const
+{
+    if (!useBinaryResults || columnTypes.empty())
+        return false;
+
+    // Merged keyset ranges are ordered again by their projected values, so a key the store cannot
+    // decode turns the page to text rather than being projected as a text cast
+    if (canUseKeyset())
+    {
+        for (int col : keysetColumns())
+        {
+            if (!ResultStore::decodesBinary(columnTypes[col]))
+                return false;
+        }
+    }
+    return true;
+}
+
+std::string Table::selectExpression(int col) const
+{
+    std::string name = SchemaCatalog::quoteIdentifier(columns[col]);
+    if (previewsColumn(col))
+        return previewExpression(name);
+
+    // Types the store cannot decode from binary are sent as text instead
+    return !fetchesBinary() || ResultStore::decodesBinary(columnTypes[col]) ? name : name + "::text AS " + name;
+}
+
+bool Table::previewsColumn(int col) const
+{
+    // Columns that identify rows or order keyset pages are needed whole
+    if (col >= static_cast<int>(columnTypes.size()) || !previewsType(columnTypes[col]))
+        return false;
+    if (std::find(rowKeyColumns.begin(), rowKeyColumns.end(), col) != rowKeyColumns.end() || std::find(primaryKeyColumns.begin(), primaryKeyColumns.end(), col) != primaryKeyColumns.end())
+        return false;
+    return !canUseKeyset() || col != sortColumn;
+}
+
+bool Table::previewsType(Oid type)
+{
+    switch (type)
+    {
+    case 25:   // text
+    case 1043: // varchar
+    case 114:  // json
+    case 3802: // jsonb
+    case 17:   // bytea
+    case 142:  // xml
+        return true;
+    default:
+        // Arrays and other types the store cannot decode arrive as text of any length
+        return !ResultStore::decodesBinary(type);
+    }
+}
+
+std::string Table::previewExpression(const std::string &name) { return "left(" + name + "::text, " + std::to_string(PreviewLength) + ") AS " + name; }
+
+std::string Table::sizeExpression(const std::string &name, Oid type, int col)
+{
+    // octet_length of text and bytea reads the stored length without detoasting the value; other types are measured as text
+    bool stored = type == 25 || type == 1043 || type == 17;
+    return "octet_length(" + name + (stored ? "" : "::text") + ") AS " + SizeColumnPrefix + std::to_string(col);
+}
+
+void Table::findSizeColumns()
+{
+    sizeColumns.assign(columns.size(), -1);
+    for (int col = 0; col < static_cast<int>(columns.size()); col++)
+    {
+        sizeColumns[col] = hiddenColumn((SizeColumnPrefix + std::to_string(col)).c_str());
+    }
+}
+
+long long Table::valueSize(int row, int col) const
+{
+    int sizeCol = col < static_cast<int>(sizeColumns.size()) ? sizeColumns[col] : -1;
+    if (sizeCol < 0 || rows.isNull(row, sizeCol))
+        return -1;
+    if (rows.columnKind(sizeCol) == ResultStore::Kind::Int)
+        return rows.intValue(row, sizeCol);
+    return std::atoll(rows.text(row, sizeCol).c_str());
+}
+
+bool Table::isTruncated(int row, int col) const
+{
+    // bytea previews are hex text: two digits per byte after a \x prefix
+    long long size = valueSize(row, col);
+    if (size < 0 || rows.isNull(row, col))
+        return false;
+    long long textSize = columnTypes[col] == 17 ? 2 + 2 * size : size;
+    return textSize > static_cast<long long>(rows.value(row, col).size());
+}
+
+std::string Table::buildSelectList() const
+{
+    if (columnTypes.empty())
+        return "*" + buildHiddenColumns();
+
+    std::string list;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        list += (i > 0 ? ", " : "") + selectExpression(static_cast<int>(i));
+    }
+    return list + buildHiddenColumns();
+}
+
+std::string Table::buildHiddenColumns() const
+{
+    std::string list;
+    for (int col = 0; col < static_cast<int>(columns.size()); col++)
+    {
+        if (previewsColumn(col))
+        {
+            list += ", " + sizeExpression(SchemaCatalog::quoteIdentifier(columns[col]), columnTypes[col], col);
+        }
+    }
+    if (fetchRowVersion)
+    {
+        list += std::string(", xmin::text AS ") + RowVersionColumn;
+    }
+    if (identifyByCtid)
+    {
+        list += std::string(", ctid::text AS ") + CtidColumn;
+    }
+    return list;
+}
+
+int Table::hiddenColumn(const char *name) const
+{
+    for (int col = static_cast<int>(columns.size()); col < rows.columnCount(); col++)
+    {
+        if (rows.columnName(col) == name)
+            return col;
+    }
+    return -1;
+}
+
+void Table::chooseRowIdentity()
+{
+    // System columns exist on plain and partitioned tables; views keep matching the whole row
+    const SchemaCatalog::Relation *relation = catalogRelation();
+    fetchRowVersion = relation && (relation->kind == 'r' || relation->kind == 'p');
+
+    rowKeyColumns = primaryKeyColumns;
+    if (rowKeyColumns.empty() && relation && relation->columns.size() == columns.size())
+    {
+        // NULLs never compare equal, so a unique index identifies rows only when all its columns are NOT NULL
+        for (const auto &index : relation->indexes)
+        {
+            bool usable = index.unique && !index.partial && !index.columns.empty() &&
+                          std::all_of(index.columns.begin(), index.columns.end(), [relation](int col) { return col >= 0 && relation->columns[col].notNull; });
+            if (usable)
+            {
+                rowKeyColumns = index.columns;
+                break;
+            }
+        }
+    }
+
+    // ctid is unique only within one heap, so partitions of a partitioned table cannot rely on it
+    identifyByCtid = rowKeyColumns.empty() && relation && relation->kind == 'r';
+}
+
+SqlQuery Table::buildFilteredQuery() const { return buildPageQuery(currentOffset); }
+
+SqlQuery Table::buildPageQuery(int offset) const
+{
+    SqlQuery query;
+    query.resultFormat = fetchesBinary() ? 1 : 0;
+    std::string select = buildSelect(query);
+
+    if (!canUseKeyset())
+    {
+        // Incorporate the selected sort column and order.
+        query.sql = select + " ORDER BY " + orderColumn(sortColumn) + (sortAscending ? " ASC" : " DESC");
+        query.sql += " LIMIT " + query.bind(std::to_string(rowsPerPage + 1));
+        query.sql += " OFFSET " + query.bind(std::to_string(offset));
+        return query;
+    }
+
+    std::string order = buildKeysetOrder();
+    std::string limit = " LIMIT " + query.bind(std::to_string(rowsPerPage + 1));
+
+    // Without the previous page's cursor (e.g. right after a sort change) fall back to OFFSET once
+    int page = offset / rowsPerPage;
+    auto cursor = pageCursors.find(page - 1);
+    if (page == 0 || cursor == pageCursors.end())
+    {
+        query.sql = select + order + limit + " OFFSET " + query.bind(std::to_string(offset));
+        return query;
+    }
+
+    std::vector<std::string> predicates = buildKeysetPredicates(cursor->second, query);
+    if (predicates.size() == 1)
+    {
+        query.sql = select + " AND " + predicates[0] + order + limit;
+        return query;
+    }
+
+    // Rows after the cursor fall into two index-friendly ranges (e.g. non-NULL keys, then the NULL group); merge them.
+    // The merged rows take the relation's alias, so the same order applies to their keys, which are projected as is.
+    query.sql = "SELECT * FROM ((" + select + " AND " + predicates[0] + order + limit + ") UNION ALL (" + select + " AND " + predicates[1] + order + limit + ")) AS " + RelationAlias + order + limit;
+    return query;
+}
+
+void Table::nextPage()
+{
+    currentOffset += rowsPerPage;
+    loadTableData(currentTable, currentOffset);
+}
+
+void Table::previousPage()
+{
+    currentOffset = std::max(0, currentOffset - rowsPerPage);
+    loadTableData(currentTable, currentOffset);
+}
+
+void Table::setFilter(size_t col, const std::string &text)
+{
+    if (col >= columnFilters.size())
+        return;
+
+    columnFilters[col] = text;
+    updateHeaderLabels();
+    reloadWithFilters();
+}
+
+void Table::setSort(const std::vector<RowSorter::Key> &keys)
+{
+    // Applied on the next render, like a header click
+    sortKeys = keys;
+    rowOrderDirty = true;
+}
+
+void Table::setStreaming(bool enabled)
+{
+    streamRows = enabled;
+    resetPageCursors();
+    loadTableData(currentTable, 0);
+}
+
+void Table::reloadWithFilters()
+{
+    if (!executor)
+        return;
+
+    resetPageCursors();
+    displayRowsDirty = true;
+    requestView();
+}
+
+void Table::updateHeaderLabels()
+{
+    headerLabels.resize(columns.size());
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        headerLabels[i] = columnFilters[i].empty() ? columns[i] : columns[i] + " (*)";
+    }
+}
+
+bool Table::canUseKeyset() const { return useKeysetPagination && !primaryKeyColumns.empty(); }
+
+std::vector<int> Table::keysetColumns() const
+{
+    std::vector<int> keyCols = {sortColumn};
+    for (int col : primaryKeyColumns)
+    {
+        if (col != sortColumn)
+        {
+            keyCols.push_back(col);
+        }
+    }
+    return keyCols;
+}
+
+std::string Table::buildKeysetOrder() const
+{
+    std::string order = " ORDER BY ";
+    std::vector<int> keyCols = keysetColumns();
+    for (size_t i = 0; i < keyCols.size(); i++)
+    {
+        order += (i > 0 ? ", " : "") + orderColumn(keyCols[i]) + (sortAscending ? " ASC" : " DESC");
+    }
+    return order;
+}
+
+std::vector<std::string> Table::buildKeysetPredicates(const PageCursor &cursor, SqlQuery &query) const
+{
+    std::vector<int> keyCols = keysetColumns();
+    const char *op = sortAscending ? " > " : " < ";
+    std::string sortName = SchemaCatalog::quoteIdentifier(columns[keyCols[0]]);
+
+    // Row-value comparison over keyCols[first..], bound as typed parameters
+    auto rowCompare = [&](size_t first)
+    {
+        std::string lhs;
+        std::string rhs;
+        for (size_t i = first; i < keyCols.size(); i++)
+        {
+            lhs += (i > first ? ", " : "") + SchemaCatalog::quoteIdentifier(columns[keyCols[i]]);
+            rhs += (i > first ? ", " : "") + query.bind(cursor.values[i], columnTypes[keyCols[i]]);
+        }
+        return "(" + lhs + ")" + op + "(" + rhs + ")";
+    };
+
+    std::vector<std::string> predicates;
+    if (!cursor.sortIsNull)
+    {
+        predicates.push_back(rowCompare(0));
+        // Ascending order puts NULLs last, so the NULL group is still ahead of a non-NULL cursor
+        if (sortAscending && !columnNotNull[keyCols[0]])
+        {
+            predicates.push_back(sortName + " IS NULL");
+        }
+    }
+    else
+    {
+        predicates.push_back(sortName + " IS NULL AND " + rowCompare(1));
+        // Descending order puts NULLs first, so every non-NULL row is still ahead of a NULL cursor
+        if (!sortAscending)
+        {
+            predicates.push_back(sortName + " IS NOT NULL");
+        }
+    }
+    return predicates;
+}
+
+Table::ResultPtr Table::fetchColumnKeys(PGconn *conn, StatementCache &statements, const std::string &relation)
+{
+    // One row per column: name, NOT NULL constraint, part of the primary key, type
+    SqlQuery query;
+    query.sql = "SELECT a.attname, a.attnotnull, EXISTS(SELECT 1 FROM pg_index i WHERE i.indrelid = a.attrelid AND i.indisprimary AND a.attnum = ANY(i.indkey)), a.atttypid "
+                "FROM pg_attribute a WHERE a.attrelid = " +
+                query.bind(relation) + "::regclass AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum";
+
+    PGresult *result = statements.execute(conn, query);
+    if (PQresultStatus(result) != PGRES_TUPLES_OK)
+    {
+        std::cerr << "Key lookup failed: " << PQerrorMessage(conn) << std::endl;
+        PQclear(result);
+        return nullptr;
+    }
+    return ResultPtr(result, PQclear);
+}
+
+void Table::loadColumnKeys(PGresult *result)
+{
+    primaryKeyColumns.clear();
+    columnNotNull.assign(columns.size(), false);
+
+    for (int i = 0; i < PQntuples(result); i++)
+    {
+        auto it = std::find(columns.begin(), columns.end(), PQgetvalue(result, i, 0));
+        if (it == columns.end())
+            continue;
+
+        // The first page may have fetched previews as text; filters and edits need the declared type
+        int col = static_cast<int>(it - columns.begin());
+        if (col < static_cast<int>(columnTypes.size()))
+        {
+            columnTypes[col] = static_cast<Oid>(std::strtoul(PQgetvalue(result, i, 3), nullptr, 10));
+        }
+        bool isPrimaryKey = std::string(PQgetvalue(result, i, 2)) == "t";
+        columnNotNull[col] = isPrimaryKey || std::string(PQgetvalue(result, i, 1)) == "t";
+        if (isPrimaryKey)
+        {
+            primaryKeyColumns.push_back(col);
+        }
+    }
+    chooseRowIdentity();
+}
+
+void Table::recordPageCursor()
+{
+    if (!canUseKeyset())
+        return;
+
+    int lastRow = rows.rowCount() - 1;
+    if (lastRow < 0)
+        return;
+
+    std::vector<int> keyCols = keysetColumns();
+    PageCursor cursor;
+    cursor.sortIsNull = rows.isNull(lastRow, keyCols[0]);
+    for (int col : keyCols)
+    {
+        cursor.values.push_back(rows.text(lastRow, col));
+    }
+    pageCursors[currentOffset / rowsPerPage] = std::move(cursor);
+}
+
+void Table::resetPageCursors() { pageCursors.clear(); }
+
+SqlQuery Table::buildStreamQuery() const
+{
+    SqlQuery query;
+    query.resultFormat = fetchesBinary() ? 1 : 0;
+    query.sql = buildSelect(query) + " ORDER BY " + orderColumn(sortColumn) + (sortAscending ? " ASC" : " DESC");
+    return query;
+}
+
+void Table::requestStream(const SqlQuery &query)
+{
+    int generation = beginLoad();
+    auto stop = std::make_shared<std::atomic<bool>>(false);
+    streamStop = stop;
+    streaming = true;
+    streamTruncated = false;
+    int maxRows = maxResidentRows;
+    QueryExecutor *exec = executor;
+
+    executor->submit(loadOwner(),
+                     [this, exec, generation, query, stop, maxRows](PGconn *conn) -> QueryExecutor::Completion
+                     {
+                         // The first batch replaces the current page, later ones are appended as they arrive
+                         bool first = true;
+                         auto deliver = [this, exec, generation, &first](const PagePtr &batch)
+                         {
+                             bool replace = first;
+                             first = false;
+                             exec->post(loadOwner(),
+                                        [this, generation, batch, replace]()
+                                        {
+                                            if (generation != loadGeneration)
+                                                return;
+                                            if (replace)
+                                            {
+                                                applyData(batch, nullptr, false);
+                                            }
+                                            else
+                                            {
+                                                appendRows(*batch);
+                                            }
+                                        });
+                         };
+
+                         bool truncated = streamResult(conn, exec->statements(), query, maxRows, *stop, deliver);
+                         return [this, generation, truncated]()
+                         {
+                             if (generation == loadGeneration)
+                             {
+                                 streaming = false;
+                                 streamTruncated = truncated;
+                             }
+                         };
+                     });
+}
+
+void Table::stopStream()
+{
+    if (streamStop)
+    {
+        *streamStop = true;
+        streamStop.reset();
+    }
+    streaming = false;
+}
+
+void Table::appendRows(const ResultStore &batch)
+{
+    // Existing row indices stay valid, so an open editor survives appends
+    int first = rows.rowCount();
+    rows.append(batch);
+    if (!sortKeys.empty())
+    {
+        // Appended rows have to be merged into the header sort, which rebuilds the display rows
+        rowOrderDirty = true;
+        displayRowsDirty = true;
+    }
+    if (!displayRowsDirty)
+    {
+        updateFilterMatches();
+    }
+    for (int row = first; row < rows.rowCount(); row++)
+    {
+        rowOrder.push_back(row);
+        if (!displayRowsDirty && shouldShowRow(row))
+        {
+            displayRows.push_back(row);
+        }
+    }
+}
+
+bool Table::streamResult(PGconn *conn, StatementCache &statements, const SqlQuery &query, int maxRows, const std::atomic<bool> &stop, const std::function<void(const PagePtr &)> &deliver)
+{
+    using Clock = std::chrono::steady_clock;
+    uint64_t start = Trace::now();
+
+    std::vector<const char *> values;
+    for (const auto &param : query.params)
+    {
+        values.push_back(param.c_str());
+    }
+    const char *statement = statements.prepare(conn, query);
+    if (!statement || !PQsendQueryPrepared(conn, statement, static_cast<int>(values.size()), values.data(), nullptr, nullptr, query.resultFormat))
+    {
+        std::cerr << "Streaming query failed: " << PQerrorMessage(conn) << std::endl;
+        return false;
+    }
+    Trace::record("send", "query", start, Trace::now(), query.sql);
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    PQsetChunkedRowsMode(conn, 1000);
+#else
+    PQsetSingleRowMode(conn);
+#endif
+
+    // Small, quick first batch for time-to-first-row, then larger batches to keep UI-side appends cheap
+    PagePtr batch;
+    bool delivered = false;
+    bool truncated = false;
+    bool cancelled = false;
+    int total = 0;
+    Clock::time_point lastFlush = Clock::now();
+    auto flush = [&]()
+    {
+        if (!delivered)
+        {
+            Trace::record("first rows", "query", start, Trace::now(), query.sql);
+        }
+        deliver(batch);
+        batch.reset();
+        delivered = true;
+        lastFlush = Clock::now();
+    };
+
+    while (true)
+    {
+        if (!cancelled && (stop || truncated))
+        {
+            QueryExecutor::cancelQuery(conn);
+            cancelled = true;
+        }
+
+        if (PQisBusy(conn))
+        {
+            if (batch && !cancelled && Clock::now() - lastFlush >= std::chrono::milliseconds(delivered ? 50 : 10))
+            {
+                flush();
+            }
+            pollfd socket = {PQsocket(conn), POLLIN, 0};
+            poll(&socket, 1, 10);
+            if (!PQconsumeInput(conn))
+                break;
+            continue;
+        }
+
+        PGresult *res = PQgetResult(conn);
+        if (!res)
+            break;
+
+        ExecStatusType status = PQresultStatus(res);
+#ifdef LIBPQ_HAS_CHUNK_MODE
+        bool hasRows = status == PGRES_SINGLE_TUPLE || status == PGRES_TUPLES_CHUNK;
+#else
+        bool hasRows = status == PGRES_SINGLE_TUPLE;
+#endif
+        if (hasRows && !cancelled)
+        {
+            Trace::Scope trace("decode", "query");
+            int before = batch ? batch->rowCount() : 0;
+            if (!batch)
+            {
+                batch = std::make_shared<ResultStore>();
+                batch->assign(res, maxRows - total);
+            }
+            else
+            {
+                batch->append(res, maxRows - total);
+            }
+            total += batch->rowCount() - before;
+            truncated = total >= maxRows;
+
+            if (batch->rowCount() >= (delivered ? 10000 : 100) || Clock::now() - lastFlush >= std::chrono::milliseconds(delivered ? 50 : 10))
+            {
+                flush();
+            }
+        }
+        else if (status == PGRES_TUPLES_OK && !delivered && !batch)
+        {
+            // The terminating result carries column metadata even when no rows matched
+            batch = std::make_shared<ResultStore>();
+            batch->assign(res, 0);
+        }
+        else if (!hasRows && status != PGRES_TUPLES_OK && !cancelled)
+        {
+            std::cerr << "Streaming query failed: " << PQerrorMessage(conn) << std::endl;
+        }
+        PQclear(res);
+    }
+
+    if (batch && !stop)
+    {
+        flush();
+    }
+    Trace::record("stream", "query", start, Trace::now(), query.sql);
+    return truncated;
+}
+
+void Table::renderStreamingControls()
+{
+    if (streaming)
+    {
+        ImGui::Text("Streaming... %d rows", rows.rowCount());
+    }
+    else
+    {
+        ImGui::Text("%d rows%s", rows.rowCount(), streamTruncated ? " (row cap reached)" : "");
+    }
+
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(100);
+    if (ImGui::InputInt("Cap", &maxResidentRows, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue))
+    {
+        maxResidentRows = std::max(maxResidentRows, rowsPerPage);
+        loadTableData(currentTable, 0);
+    }
+    if (ImGui::IsItemHovered())
+    {
+        ImGui::SetTooltip("Maximum number of rows kept in memory while streaming");
+    }
+}
+
+SqlQuery Table::buildExportSource(bool wholeTable) const
+{
+    // Plain tables are copied straight from the heap; views and the filtered, sorted view go through a query
+    SqlQuery query;
+    const SchemaCatalog::Relation *relation = catalogRelation();
+    if (wholeTable && relation && relation->kind == 'r')
+    {
+        query.sql = relationName;
+        return query;
+    }
+
+    std::string list;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        list += (i > 0 ? ", " : "") + SchemaCatalog::quoteIdentifier(columns[i]);
+    }
+    query.sql = "(SELECT " + list + " FROM " + relationName;
+    if (!wholeTable)
+    {
+        query.sql += " WHERE 1=1" + buildFilterClause(query) + buildExportOrder();
+    }
+    query.sql += ")";
+    return query;
+}
+
+std::string Table::buildExportOrder() const
+{
+    // A header sort is what the view shows, so it wins over the server sort column. NULLs sort
+    // last ascending and first descending, as in RowSorter.
+    if (sortKeys.empty())
+        return " ORDER BY " + SchemaCatalog::quoteIdentifier(columns[sortColumn]) + (sortAscending ? " ASC" : " DESC");
+
+    std::string order = " ORDER BY ";
+    for (size_t i = 0; i < sortKeys.size(); i++)
+    {
+        order += (i > 0 ? ", " : "") + SchemaCatalog::quoteIdentifier(columns[sortKeys[i].column]) + (sortKeys[i].descending ? " DESC" : " ASC");
+    }
+    return order;
+}
+
+bool Table::startExport(const std::string &path, Exporter::Format format, bool wholeTable)
+{
+    if (columns.empty())
+        return false;
+
+    long long expected = exactRows >= 0 ? exactRows : estimatedRows;
+    if (wholeTable && isFilterActive())
+    {
+        const SchemaCatalog::Relation *relation = catalogRelation();
+        expected = relation ? relation->estimatedRows : -1;
+    }
+    return exporter.start(buildExportSource(wholeTable), columns, path, format, expected);
+}
+
+void Table::renderExportControls()
+{
+    if (exporter.isRunning())
+    {
+        long long rowsDone = exporter.rowsWritten();
+        double seconds = std::max(exporter.elapsedSeconds(), 0.001);
+        char overlay[96];
+        snprintf(overlay, sizeof(overlay), "%lld rows, %.1f MB/s", rowsDone, exporter.bytesWritten() / seconds / (1024.0 * 1024.0));
+        float fraction = exporter.expectedRows() > 0 ? std::min(1.0f, static_cast<float>(rowsDone) / exporter.expectedRows()) : 0.0f;
+        ImGui::ProgressBar(fraction, ImVec2(220, 0), overlay);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Exporting to %s", exporter.path().c_str());
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel Export"))
+        {
+            exporter.cancel();
+        }
+        return;
+    }
+
+    static const char *formats[] = {"CSV", "TSV", "Binary (COPY)"};
+    static const Exporter::Format formatValues[] = {Exporter::Format::Csv, Exporter::Format::Tsv, Exporter::Format::Binary};
+
+    if (ImGui::Button("Export"))
+    {
+        // The suggested name follows the table; a path typed earlier is kept
+        if (exportPath[0] == '\0')
+        {
+            std::string name = currentTable + Exporter::extension(formatValues[exportFormat]);
+            snprintf(exportPath, sizeof(exportPath), "%s", name.c_str());
+        }
+        ImGui::OpenPopup("##Export");
+    }
+    if (!exporter.status().empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", exporter.status().c_str());
+    }
+
+    if (ImGui::BeginPopup("##Export"))
+    {
+        ImGui::SetNextItemWidth(300);
+        ImGui::InputText("File", exportPath, sizeof(exportPath));
+
+        ImGui::SetNextItemWidth(300);
+        int previous = exportFormat;
+        if (ImGui::Combo("Format", &exportFormat, formats, IM_ARRAYSIZE(formats)))
+        {
+            // Swap the extension when it is still the one the previous format suggested
+            std::string path = exportPath;
+            std::string oldExtension = Exporter::extension(formatValues[previous]);
+            if (path.size() >= oldExtension.size() && path.compare(path.size() - oldExtension.size(), oldExtension.size(), oldExtension) == 0)
+            {
+                path = path.substr(0, path.size() - oldExtension.size()) + Exporter::extension(formatValues[exportFormat]);
+                snprintf(exportPath, sizeof(exportPath), "%s", path.c_str());
+            }
+        }
+
+        if (ImGui::RadioButton("Current view", !exportWholeTable))
+        {
+            exportWholeTable = false;
+        }
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("All rows that match the filters, in the current sort order");
+        }
+        ImGui::SameLine();
+        if (ImGui::RadioButton("Whole table", exportWholeTable))
+        {
+            exportWholeTable = true;
+        }
+
+        if (ImGui::Button("Start") && startExport(exportPath, formatValues[exportFormat], exportWholeTable))
+        {
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+}
+
+bool Table::startImport(const std::string &path, const Importer::Options &options)
+{
+    if (columns.empty())
+        return false;
+
+    std::string relation = relationName;
+    return importer.start(relation, columns, path, options, [this, relation](bool committed) { finishImport(relation, committed); });
+}
+
+void Table::finishImport(const std::string &relation, bool committed)
+{
+    if (!committed)
+        return;
+
+    // Cached pages and the row estimate predate the new rows; the view reloads only if it still shows the table
+    if (pageCache)
+    {
+        pageCache->invalidate(relation);
+    }
+    if (relation == relationName)
+    {
+        countKey.clear();
+        resetPageCursors();
+        loadTableData(currentTable, currentOffset);
+    }
+}
+
+void Table::renderImportControls()
+{
+    if (importer.isRunning())
+    {
+        char overlay[96];
+        snprintf(overlay, sizeof(overlay), "%lld rows, %.0f rows/s", importer.rowsSent(), importer.rowsPerSecond());
+        float fraction = importer.fileBytes() > 0 ? static_cast<float>(importer.bytesRead()) / importer.fileBytes() : 0.0f;
+        ImGui::ProgressBar(fraction, ImVec2(220, 0), overlay);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("%s, %lld rows skipped", importer.status().c_str(), importer.rowsSkipped());
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel Import"))
+        {
+            importer.cancel();
+        }
+        return;
+    }
+
+    if (ImGui::Button("Import"))
+    {
+        ImGui::OpenPopup("##Import");
+    }
+    if (!importer.status().empty())
+    {
+        ImGui::SameLine();
+        ImGui::TextDisabled("%s", importer.status().c_str());
+        if (ImGui::IsItemHovered())
+        {
+            std::vector<Importer::RowError> errors = importer.rowErrors();
+            if (!errors.empty())
+            {
+                ImGui::BeginTooltip();
+                for (const auto &error : errors)
+                {
+                    ImGui::Text("Row %lld: %s", error.row, error.message.c_str());
+                }
+                ImGui::EndTooltip();
+            }
+        }
+    }
+
+    if (ImGui::BeginPopup("##Import"))
+    {
+        ImGui::SetNextItemWidth(300);
+        if (ImGui::InputText("File", importPath, sizeof(importPath)))
+        {
+            importOptions.format = Importer::formatForPath(importPath);
+        }
+
+        static const char *formats[] = {"CSV", "TSV"};
+        int format = static_cast<int>(importOptions.format);
+        ImGui::SetNextItemWidth(300);
+        if (ImGui::Combo("Format", &format, formats, IM_ARRAYSIZE(formats)))
+        {
+            importOptions.format = static_cast<Importer::Format>(format);
+        }
+
+        ImGui::Checkbox("Header row", &importOptions.header);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("The first row names the columns to fill; without it the file has every column in table order");
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Skip bad rows", &importOptions.skipBadRows);
+        if (ImGui::IsItemHovered())
+        {
+            ImGui::SetTooltip("Report and skip rows with the wrong number of fields (and, on PostgreSQL 17+, values that do not convert) instead of rolling back");
+        }
+
+        ImGui::TextDisabled("Rows are added to %s in one transaction", currentTable.c_str());
+        if (ImGui::Button("Start") && startImport(importPath, importOptions))
+        {
+            ImGui::CloseCurrentPopup();
+        }
+        ImGui::EndPopup();
+    }
+}
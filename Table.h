@@ -2,7 +2,11 @@
 
 // Standard library includes
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -10,64 +14,326 @@
 #include <imgui.h>
 #include <libpq-fe.h>
 
+// Project includes
+#include "ColumnFilter.h"
+#include "ConnectionPool.h"
+#include "Exporter.h"
+#include "Importer.h"
+#include "PageCache.h"
+#include "QueryExecutor.h"
+#include "ResultStore.h"
+#include "RowSorter.h"
+#include "SchemaCatalog.h"
+#include "TextSearch.h"
+#include "Trace.h"
+
 class Table
 {
   public:
     // Constructor/Destructor
-    Table(PGconn *conn);
+    Table(ConnectionPool *pool, PageCache *pageCache = nullptr, const SchemaCatalog *catalog = nullptr);
     ~Table();
 
     // Main public interface
     void loadTableData(const std::string &tableName, int offset = 0);
     void render();
+    bool isLoading() const;
+    bool isWorking() const;
+    void cancelQueries();
+
+    // The same actions the UI performs, for driving a view without input (dbe_bench)
+    void nextPage();
+    void previousPage();
+    void setFilter(size_t col, const std::string &text);
+    void setSort(const std::vector<RowSorter::Key> &keys);
+    void setStreaming(bool enabled);
+    void stageEdit(int row, int col, const std::string &value);
+    void commitEdits();
+    bool startExport(const std::string &path, Exporter::Format format, bool wholeTable);
+    const Exporter &exportProgress() const { return exporter; }
+    bool startImport(const std::string &path, const Importer::Options &options);
+    const Importer &importProgress() const { return importer; }
+    bool isCommitting() const { return committingEdits; }
+    int pendingChangeCount() const;
+    bool hasNextPage() const { return hasMoreRows; }
+    int loadedRowCount() const { return rows.rowCount(); }
+    int columnCount() const { return static_cast<int>(columns.size()); }
+
+    // Workspace memory: a view that is not shown can give back its rows and keep its table,
+    // filters, sort and position; restoreRows() loads the same page again, usually from the page cache
+    const std::string &tableName() const { return currentTable; }
+    size_t memoryBytes() const;
+    bool releaseRows();
+    void restoreRows();
+    bool hasReleasedRows() const { return rowsReleased; }
 
   private:
-    // Database connection and state
-    PGconn *conn;
+    using ResultPtr = std::shared_ptr<PGresult>;
+    using PagePtr = std::shared_ptr<ResultStore>;
+
+    // Database connection and state; page loads and edits run on the pool's
+    // foreground connection, prefetch and counts on its background ones
+    ConnectionPool *pool;
+    QueryExecutor *executor;
     std::string currentTable;
+    std::string relationName; // currentTable quoted for SQL
+
+    // Column names, types and keys come from the schema catalog when it knows the
+    // table, so even the first page is a typed, binary, keyset-ordered query. Both are
+    // resolved again whenever the catalog changes, so a table opened before the
+    // catalog knew it (or altered since) picks up its real name and columns.
+    const SchemaCatalog *catalog;
+    uint64_t catalogVersion = 0;
+    const SchemaCatalog::Relation *catalogRelation() const;
+    void loadCatalogColumns(const SchemaCatalog::Relation &relation);
+    void resetColumns();
+    void resolveRelation();
     std::vector<std::string> columns;
-    std::vector<std::vector<std::string>> rows;
+    ResultStore rows;
+    std::vector<int> rowOrder;
+
+    // Rows that pass the client-side filters, in display order; rebuilt only when
+    // the data, order or filters change so frames just walk the visible slice
+    std::vector<int> displayRows;
+    bool displayRowsDirty = true;
+    void rebuildDisplayRows();
+
+    // Compiled client-side filters: each keeps its folded needle and a bitmap of the
+    // rows it matches. A bitmap is recomputed only when its filter text or the cell
+    // contents change (rowsVersion), and extended when rows are appended, so sorting
+    // or editing another filter never rescans a column. Rows the server fetched
+    // under a filter are not checked against it again, since the client's folding
+    // and formatting can differ from the server's locale and TimeZone.
+    struct CompiledFilter
+    {
+        std::string text;
+        TextSearch search;
+        std::vector<uint64_t> matches;
+        int coveredRows = 0;
+        uint64_t rowsVersion = 0;
+    };
+    std::vector<CompiledFilter> compiledFilters;
+    uint64_t rowsVersion = 0;
+    std::vector<std::string> requestedFilters; // Filters of the latest load
+    std::vector<std::string> rowsFilters;      // Filters the server applied to the rows on screen
+    void updateFilterMatches();
+    std::vector<Oid> columnTypes;
     int currentOffset = 0;
     int rowsPerPage = 100;
     bool hasMoreRows = false;
+    bool rowsReleased = false;
+
+    // Async request tracking; completions from superseded loads are dropped, and page loads and
+    // streams run under their own owner so superseding one cancels it without touching edits
+    int loadGeneration = 0;
+    const void *loadOwner() const { return &loadGeneration; }
+
+    // Binary results are decoded into typed columns; the first page of a table is
+    // read as text because column types are not known before it arrives
+    bool useBinaryResults = true;
+    bool fetchesBinary() const;
 
     // Table data management
     void initializeTable(const std::string &tableName, int offset);
-    void executeQuery(const std::string &query, PGresult *&result);
-    void clearAndExecuteQuery(const std::string &query, PGresult *&result);
-    void loadColumns(PGresult *result);
-    void loadRows(PGresult *result);
-    void loadRowsFromResult(PGresult *result);
-    std::string buildInitialQuery(int offset) const;
-    std::string buildFilteredQuery() const;
-    void checkForMoreRows();
-
-    // Editing functionality
+    int beginLoad();
+    void requestInitialData();
+    void requestData(const SqlQuery &query);
+    void requestView();
+    void applyData(const PagePtr &page, const ResultPtr &keysResult, bool moreRows);
+    static ResultPtr executeQuery(PGconn *conn, StatementCache &statements, const SqlQuery &query);
+    static PagePtr fetchPage(PGconn *conn, StatementCache &statements, const SqlQuery &query, int limit, bool &moreRows);
+    void loadColumns(const ResultStore &page, int count);
+    void initializeFilters();
+    static PagePtr loadRows(const PGresult *result, int limit);
+    static SqlQuery buildInitialQuery(const std::string &relation, const PGresult *columnKeys, int offset, int limit);
+    SqlQuery buildFilteredQuery() const;
+    SqlQuery buildPageQuery(int offset) const;
+    std::string buildSelect(SqlQuery &query) const;
+    std::string orderColumn(int col) const;
+    std::string buildSelectList() const;
+    std::string selectExpression(int col) const;
+
+    // Wide columns (text, json, bytea, arrays, ...) are fetched as a bounded text
+    // preview plus the full value's size in a hidden column, so a page costs
+    // PreviewLength characters per cell however large the values are. Key columns
+    // are always fetched whole since they identify rows.
+    static constexpr int PreviewLength = 256;
+    std::vector<int> sizeColumns; // Hidden size column per visible column, -1 if not previewed
+    bool previewsColumn(int col) const;
+    static bool previewsType(Oid type);
+    static std::string previewExpression(const std::string &name);
+    static std::string sizeExpression(const std::string &name, Oid type, int col);
+    void findSizeColumns();
+    long long valueSize(int row, int col) const;
+    bool isTruncated(int row, int col) const;
+    std::string buildFilterClause(SqlQuery &query) const;
+
+    // Keyset pagination: the sort column followed by the primary key gives a
+    // unique row order, so each page seeks past the last row of the previous
+    // page instead of scanning and discarding OFFSET rows
+    struct PageCursor
+    {
+        std::vector<std::string> values;
+        bool sortIsNull = false;
+    };
+    bool useKeysetPagination = true;
+    std::vector<int> primaryKeyColumns;
+    std::vector<bool> columnNotNull;
+    std::map<int, PageCursor> pageCursors;
+    bool canUseKeyset() const;
+    std::vector<int> keysetColumns() const;
+    std::string buildKeysetOrder() const;
+    std::vector<std::string> buildKeysetPredicates(const PageCursor &cursor, SqlQuery &query) const;
+    static ResultPtr fetchColumnKeys(PGconn *conn, StatementCache &statements, const std::string &relation);
+    void loadColumnKeys(PGresult *result);
+
+    // Row identity for updates: the primary key, else a unique index over NOT NULL
+    // columns, else the tuple's ctid. Tables also fetch xmin as a row version after
+    // the visible columns, so an update of a row that changed since it was loaded
+    // matches nothing and is reported as a conflict instead of overwriting it.
+    std::vector<int> rowKeyColumns;
+    bool fetchRowVersion = false;
+    bool identifyByCtid = false;
+    void chooseRowIdentity();
+    std::string buildHiddenColumns() const;
+    int hiddenColumn(const char *name) const;
+    void recordPageCursor();
+    void resetPageCursors();
+
+    // Row counts: a catalog or planner estimate per table and filter set, and an
+    // exact count(*) only when asked for; both run in the background
+    long long estimatedRows = -1;
+    long long exactRows = -1;
+    bool countingRows = false;
+    std::string countKey;
+    std::string rowCountKey() const;
+    SqlQuery buildCountQuery(const std::string &select) const;
+    void requestRowEstimate();
+    void requestExactCount();
+    static long long fetchRowEstimate(PGconn *conn, StatementCache &statements, const std::string &relation, bool filtered, const SqlQuery &explain, std::string &scan);
+
+    // The scan node the planner chose for the filtered query, from the same EXPLAIN as the estimate
+    std::string filterScan;
+    void renderRowCount();
+    const void *countOwner() const { return &countKey; }
+
+    // Page cache and prefetch: pages are keyed by their query, neighbours of the
+    // current page are fetched in the background, and a navigation that hits an
+    // in-flight prefetch waits for it instead of issuing the query again
+    PageCache *pageCache;
+    std::map<std::string, std::shared_ptr<std::atomic<bool>>> prefetching; // Key to a flag that skips the prefetch if it has not started
+    std::string awaitedKey;
+    std::string pageKey(const SqlQuery &query) const;
+    void cachePage(const std::string &relation, const std::string &key, const PagePtr &page, bool moreRows, uint64_t cacheGeneration);
+    void prefetchNeighbors();
+    void prefetchPage(int offset);
+    const void *prefetchOwner() const { return &prefetching; }
+
+    // Streaming mode: the whole filtered result is read in single-row (or chunked)
+    // mode and appended in batches while the query runs, up to maxResidentRows
+    bool streamRows = false;
+    bool streaming = false;
+    bool streamTruncated = false;
+    int maxResidentRows = 1000000;
+    std::shared_ptr<std::atomic<bool>> streamStop;
+    void requestStream(const SqlQuery &query);
+    void stopStream();
+    void appendRows(const ResultStore &batch);
+    SqlQuery buildStreamQuery() const;
+    static bool streamResult(PGconn *conn, StatementCache &statements, const SqlQuery &query, int maxRows, const std::atomic<bool> &stop, const std::function<void(const PagePtr &)> &deliver);
+    void renderStreamingControls();
+
+    // Export: the whole table, or the rows the current filters and sort select, copied
+    // to a file on a background connection; it keeps running when another table is opened
+    Exporter exporter;
+    char exportPath[512] = "";
+    int exportFormat = 0;
+    bool exportWholeTable = false;
+    SqlQuery buildExportSource(bool wholeTable) const;
+    std::string buildExportOrder() const;
+    void renderExportControls();
+
+    // Import: a CSV or TSV file copied into the current table in one transaction on a
+    // background connection; the view reloads when it commits
+    Importer importer;
+    char importPath[512] = "";
+    Importer::Options importOptions;
+    void finishImport(const std::string &relation, bool committed);
+    void renderImportControls();
+
+    // Editing functionality. The editor buffer grows with its text; a truncated cell
+    // opens once its full value has been fetched by the row's key or ctid.
     bool isEditing = false;
     int editRow = -1;
     int editCol = -1;
-    char editBuffer[256];
+    std::string editBuffer;
+    std::string editOriginal;
+    bool loadingFullValue = false;
+    int fullValueRequest = 0;
+    bool canLoadFullValue(int row) const;
+    void requestFullValue(int row, int col);
+    static int resizeEditBuffer(ImGuiInputTextCallbackData *data);
     void handleCellClick(int row, int col);
     void saveEdit();
     void cancelEdit();
-    std::string generateUpdateQuery(int row, int col, const std::string &newValue);
+
+    // Pending changes: edits are buffered per row, shown as dirty cells and committed
+    // together in one transaction sent through libpq pipeline mode. Rows are keyed by
+    // (pageVersion, row) and remember their original values, so a change stays valid
+    // after the page it was made on has been replaced.
+    struct PendingChange
+    {
+        std::string value;
+        std::string returning;
+        std::string size; // Hidden size column of a previewed column, returned after the values
+    };
+    struct PendingRow
+    {
+        std::string table;
+        std::vector<std::string> columnNames;
+        std::vector<std::string> original;
+        std::vector<bool> originalNull;
+        std::vector<bool> originalPreview; // original holds a preview; matched with previewExpression
+        std::vector<int> keyColumns;
+        std::string rowVersion;
+        std::string ctid;
+        std::map<int, PendingChange> changes;
+        int resultFormat = 0;
+        int revision = 0;
+        std::string error;
+    };
+    int pageVersion = 0;
+    std::map<std::pair<int, int>, PendingRow> pendingRows;
+    bool committingEdits = false;
+    const std::string *findPendingValue(int row, int col) const;
+    void applyCommittedEdits(const std::vector<std::pair<std::pair<int, int>, int>> &committed, const std::vector<PagePtr> &returned, const std::vector<std::string> &errors, bool success);
+    void discardEdits();
+    SqlQuery generateUpdateQuery(const PendingRow &pending) const;
+    static bool executeInTransaction(PGconn *conn, StatementCache &statements, const std::vector<SqlQuery> &queries, std::vector<ResultPtr> &results, std::vector<std::string> &errors);
+    void renderPendingEditControls();
 
     // Sorting functionality
-    ImGuiTableSortSpecs *currentSort = nullptr;
+    std::vector<RowSorter::Key> sortKeys; // Header sort of the resident rows, copied from ImGui's specs
+    bool rowOrderDirty = false;
+    double lastSortMillis = 0;
     int sortColumn = 0;
     bool sortAscending = true;
     void handleSorting();
-    bool compareRows(const std::vector<std::string> &a, const std::vector<std::string> &b) const;
+    void sortRows();
 
     // Filtering functionality
     std::vector<std::string> columnFilters;
+    std::vector<std::string> headerLabels;
     char filterBuffer[256];
     int activeFilterColumn = -1;
     int lastActiveColumn = -1;
     bool isFilterActive() const;
     bool shouldShowFilter(size_t colIndex) const;
-    bool shouldShowRow(const std::vector<std::string> &row) const;
+    ColumnFilter parseFilter(size_t colIndex, const std::string &text) const;
+    std::string describeFilter(size_t colIndex, const std::string &text) const;
+    bool shouldShowRow(int row) const;
     void reloadWithFilters();
+    void updateHeaderLabels();
 
     // UI Rendering - Table
     void setupTableFlags(ImGuiTableFlags &flags) const;
@@ -0,0 +1,107 @@
+#include "TextSearch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DBE_TEXTSEARCH_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DBE_TEXTSEARCH_NEON 1
+#endif
+
+namespace
+{
+#if DBE_TEXTSEARCH_SSE2
+// Folds 'A'..'Z' to lower case in all 16 lanes; bytes >= 0x80 are negative as signed and left alone
+inline __m128i foldBlock(__m128i block)
+{
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+// One bit per lane where both the first and the last needle byte match
+inline unsigned candidateMask(const char *text, size_t last, char first, char final)
+{
+    __m128i head = foldBlock(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text)));
+    __m128i tail = foldBlock(_mm_loadu_si128(reinterpret_cast<const __m128i *>(text + last)));
+    __m128i both = _mm_and_si128(_mm_cmpeq_epi8(head, _mm_set1_epi8(first)), _mm_cmpeq_epi8(tail, _mm_set1_epi8(final)));
+    return static_cast<unsigned>(_mm_movemask_epi8(both));
+}
+#elif DBE_TEXTSEARCH_NEON
+inline uint8x16_t foldBlock(uint8x16_t block)
+{
+    uint8x16_t upper = vandq_u8(vcgeq_u8(block, vdupq_n_u8('A')), vcleq_u8(block, vdupq_n_u8('Z')));
+    return vorrq_u8(block, vandq_u8(upper, vdupq_n_u8(0x20)));
+}
+
+// NEON has no movemask; narrowing leaves four bits per lane, folded back to one bit per lane
+inline unsigned candidateMask(const char *text, size_t last, char first, char final)
+{
+    uint8x16_t head = foldBlock(vld1q_u8(reinterpret_cast<const uint8_t *>(text)));
+    uint8x16_t tail = foldBlock(vld1q_u8(reinterpret_cast<const uint8_t *>(text + last)));
+    uint8x16_t both = vandq_u8(vceqq_u8(head, vdupq_n_u8(static_cast<uint8_t>(first))), vceqq_u8(tail, vdupq_n_u8(static_cast<uint8_t>(final))));
+    uint64_t nibbles = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(both), 4)), 0);
+    unsigned mask = 0;
+    for (; nibbles; nibbles &= nibbles - 1)
+    {
+        mask |= 1u << (__builtin_ctzll(nibbles) >> 2);
+    }
+    return mask;
+}
+#endif
+} // namespace
+
+TextSearch::TextSearch(std::string_view needle) : folded(needle)
+{
+    for (char &c : folded)
+    {
+        c = fold(c);
+    }
+}
+
+bool TextSearch::matches(std::string_view haystack) const
+{
+    size_t length = folded.size();
+    if (length == 0)
+        return true;
+    if (haystack.size() < length)
+        return false;
+
+    const char *text = haystack.data();
+    size_t end = haystack.size() - length + 1; // One past the last possible start
+    size_t start = 0;
+
+#if DBE_TEXTSEARCH_SSE2 || DBE_TEXTSEARCH_NEON
+    // Each block tests 16 start positions; the tail loads reach length - 1 bytes further
+    for (; start + 16 <= end; start += 16)
+    {
+        for (unsigned mask = candidateMask(text + start, length - 1, folded.front(), folded.back()); mask; mask &= mask - 1)
+        {
+            if (matchesAt(text + start + __builtin_ctz(mask)))
+                return true;
+        }
+    }
+#endif
+
+    return matchesScalar(text, start, end);
+}
+
+bool TextSearch::matchesAt(const char *text) const
+{
+    // First and last bytes already matched
+    for (size_t i = 1; i + 1 < folded.size(); i++)
+    {
+        if (fold(text[i]) != folded[i])
+            return false;
+    }
+    return true;
+}
+
+bool TextSearch::matchesScalar(const char *text, size_t from, size_t end) const
+{
+    for (size_t start = from; start < end; start++)
+    {
+        if (fold(text[start]) == folded.front() && fold(text[start + folded.size() - 1]) == folded.back() && matchesAt(text + start))
+            return true;
+    }
+    return false;
+}
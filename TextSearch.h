@@ -0,0 +1,29 @@
+#pragma once
+
+// Standard library includes
+#include <string>
+#include <string_view>
+
+// Case-insensitive substring search with the needle compiled once. The needle is
+// folded to ASCII lower case up front; haystacks are scanned 16 bytes at a time
+// (SSE2 or NEON) for positions where the needle's first and last bytes both
+// match, and only those candidates are compared in full. Bytes outside ASCII
+// compare exactly, as with tolower() in the C locale.
+class TextSearch
+{
+  public:
+    // Constructor
+    TextSearch() = default;
+    explicit TextSearch(std::string_view needle);
+
+    // Main public interface; an empty needle matches everything
+    bool matches(std::string_view haystack) const;
+    bool empty() const { return folded.empty(); }
+
+  private:
+    std::string folded;
+
+    static char fold(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c; }
+    bool matchesAt(const char *text) const;
+    bool matchesScalar(const char *text, size_t from, size_t end) const;
+};
@@ -0,0 +1,164 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+
+Trace::Slot Trace::slots[Trace::Capacity];
+std::atomic<uint64_t> Trace::head{0};
+std::atomic<const char *> Trace::threadNames[Trace::MaxThreads];
+std::atomic<uint32_t> Trace::nextThread{1};
+
+uint64_t Trace::now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+void Trace::record(const char *name, const char *category, uint64_t startNs, uint64_t endNs, std::string_view detail)
+{
+    uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots[index & (Capacity - 1)];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Event &event = slot.event;
+    event.name = name;
+    event.category = category;
+    event.startNs = startNs;
+    event.durationNs = endNs > startNs ? endNs - startNs : 0;
+    event.thread = threadId();
+    size_t length = std::min(detail.size(), sizeof(event.detail) - 1);
+    while (length < detail.size() && length > 0 && (static_cast<unsigned char>(detail[length]) & 0xC0) == 0x80)
+    {
+        length--; // Never cut a UTF-8 sequence in half
+    }
+    memcpy(event.detail, detail.data(), length);
+    event.detail[length] = '\0';
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char *name)
+{
+    uint32_t thread = threadId();
+    if (thread < MaxThreads)
+    {
+        threadNames[thread].store(name, std::memory_order_relaxed);
+    }
+}
+
+std::vector<Trace::Event> Trace::snapshot()
+{
+    std::vector<Event> events;
+    uint64_t end = head.load(std::memory_order_acquire);
+    uint64_t begin = end > Capacity ? end - Capacity : 0;
+    events.reserve(end - begin);
+
+    for (uint64_t index = begin; index < end; index++)
+    {
+        const Slot &slot = slots[index & (Capacity - 1)];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * index + 2)
+            continue; // Still being written, or already overwritten by a newer span
+
+        Event event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+        {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+std::vector<Trace::Summary> Trace::summarize(const std::vector<Event> &events)
+{
+    // Grouped by content, since equal literals in different files need not share an address
+    std::map<std::pair<std::string_view, std::string_view>, std::vector<uint64_t>> durations;
+    for (const auto &event : events)
+    {
+        durations[{event.category, event.name}].push_back(event.durationNs);
+    }
+
+    std::vector<Summary> summaries;
+    for (auto &[key, values] : durations)
+    {
+        std::sort(values.begin(), values.end());
+        auto percentile = [&values](double p) { return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))] / 1e6; };
+
+        Summary summary;
+        summary.category = key.first.data();
+        summary.name = key.second.data();
+        summary.count = values.size();
+        summary.p50Ms = percentile(0.50);
+        summary.p95Ms = percentile(0.95);
+        summary.p99Ms = percentile(0.99);
+        summary.maxMs = values.back() / 1e6;
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+bool Trace::exportChromeTrace(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    // Complete ("X") events in microseconds, plus thread names as metadata events
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (uint32_t thread = 1; thread < std::min<uint32_t>(nextThread.load(), MaxThreads); thread++)
+    {
+        const char *name = threadNames[thread].load(std::memory_order_relaxed);
+        if (!name)
+            continue;
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\"" << escape(name) << "\"}}";
+        first = false;
+    }
+
+    char times[64];
+    for (const auto &event : snapshot())
+    {
+        snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", event.startNs / 1e3, event.durationNs / 1e3);
+        out << (first ? "" : ",\n") << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << escape(event.category) << "\",\"ph\":\"X\"," << times << ",\"pid\":1,\"tid\":" << event.thread;
+        if (event.detail[0])
+        {
+            out << ",\"args\":{\"detail\":\"" << escape(event.detail) << "\"}";
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+uint32_t Trace::threadId()
+{
+    thread_local uint32_t id = nextThread.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+std::string Trace::escape(std::string_view text)
+{
+    std::string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        }
+        else
+        {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
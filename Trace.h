@@ -0,0 +1,87 @@
+#pragma once
+
+// Standard library includes
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Process-wide latency recorder. Spans (a name, a category, start and duration,
+// the recording thread and a short detail such as the SQL) go into a fixed ring
+// buffer that any thread writes without locking: a writer claims a slot with one
+// fetch_add and publishes it through the slot's sequence number, and readers copy
+// only slots whose sequence is unchanged across the copy. Once full, the oldest
+// spans are overwritten.
+//
+// Names and categories must be string literals; they are stored as pointers.
+class Trace
+{
+  public:
+    struct Event
+    {
+        const char *name = nullptr;
+        const char *category = nullptr;
+        uint64_t startNs = 0;
+        uint64_t durationNs = 0;
+        uint32_t thread = 0;
+        char detail[64] = "";
+    };
+
+    // Records the lifetime of the scope
+    class Scope
+    {
+      public:
+        Scope(const char *name, const char *category, std::string_view detail = {}) : name(name), category(category), detail(detail), start(now()) {}
+        ~Scope() { record(name, category, start, now(), detail); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        const char *name;
+        const char *category;
+        std::string_view detail;
+        uint64_t start;
+    };
+
+    // Percentiles of one span name over the events in the buffer
+    struct Summary
+    {
+        const char *name = nullptr;
+        const char *category = nullptr;
+        size_t count = 0;
+        double p50Ms = 0;
+        double p95Ms = 0;
+        double p99Ms = 0;
+        double maxMs = 0;
+    };
+
+    // Recording; timestamps are steady-clock nanoseconds
+    static uint64_t now();
+    static void record(const char *name, const char *category, uint64_t startNs, uint64_t endNs, std::string_view detail = {});
+    static void setThreadName(const char *name);
+
+    // Reading
+    static std::vector<Event> snapshot();
+    static std::vector<Summary> summarize(const std::vector<Event> &events);
+    static bool exportChromeTrace(const std::string &path);
+    static uint64_t recordedCount() { return head.load(std::memory_order_relaxed); }
+
+  private:
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence{0}; // 2 * index + 1 while written, 2 * index + 2 once published
+        Event event;
+    };
+
+    static constexpr size_t Capacity = 1 << 14;
+    static constexpr size_t MaxThreads = 64;
+
+    static Slot slots[Capacity];
+    static std::atomic<uint64_t> head;
+    static std::atomic<const char *> threadNames[MaxThreads];
+    static std::atomic<uint32_t> nextThread;
+
+    static uint32_t threadId();
+    static std::string escape(std::string_view text);
+};
@@ -1,5 +1,7 @@
 #define GL_SILENCE_DEPRECATION
 #include "DBE.h"
+#include "FrameScheduler.h"
+#include "Trace.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -31,6 +33,10 @@ int main()
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1);
 
+    // Frames are drawn on input and when query workers hand back results, not continuously
+    FrameScheduler scheduler(window);
+    QueryExecutor::setWakeHandler(FrameScheduler::wake);
+
     // Initialize ImGui
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -40,11 +46,13 @@ int main()
 
     // Create our application
     DBE dbe;
+    Trace::setThreadName("main");
 
     // Main loop
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        scheduler.waitForFrame();
+        uint64_t frameStart = Trace::now();
 
         // Start ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
@@ -59,8 +67,9 @@ int main()
         ImGui::Begin("Database Explorer", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoBringToFrontOnFocus);
         ImGui::PopStyleVar();
 
-        // Render our application
+        // Render our application; work in progress keeps frames coming until it settles
         dbe.render();
+        scheduler.setBusy(dbe.isWorking());
 
         ImGui::End();
 
@@ -72,11 +81,15 @@ int main()
         glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+        // CPU time of the frame; the swap only waits for vsync
+        Trace::record("frame", "ui", frameStart, Trace::now());
         glfwSwapBuffers(window);
     }
 
     // Cleanup
     dbe.shutdown();
+    QueryExecutor::setWakeHandler(nullptr);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();